@@ -0,0 +1,207 @@
+#include <BoomerAMG_autotuner.h>
+
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/mpi.h>
+
+#include <algorithm>
+#include <fstream>
+
+DEAL_II_NAMESPACE_OPEN
+
+namespace TrilinosWrappers
+{
+
+
+BoomerAMGAutotuner::BoomerAMGAutotuner(const BoomerAMGParameters & base_parameters,const AdditionalData & additional_data)
+:
+base_parameters(base_parameters),
+additional_data(additional_data)
+{}
+
+void BoomerAMGAutotuner::add_search_dimension(const std::string & name,const std::vector<param_value_variant> & values){
+
+	AssertThrow(base_parameters.has_parameter(name), ExcMessage("The parameter " + name + " does not exist in the base parameters."));
+	AssertThrow(!values.empty(), ExcMessage("A search dimension needs at least one value."));
+
+	const int which = base_parameters.get_parameter_value(name).which();
+
+	for (const auto & value : values)
+		AssertThrow(value.which()==which, ExcMessage("The candidate values for " + name + " must have the type of the stored value."));
+
+	search_space.push_back({name, values});
+
+}
+
+void BoomerAMGAutotuner::add_default_search_space(const BoomerAMGParameters::AMG_type config_selection){
+
+	switch(config_selection)
+	{
+	case BoomerAMGParameters::AIR_AMG:
+		add_search_dimension("coarsen_type", {6, 8, 10});
+		add_search_dimension("relax_type", {0, 3});
+		add_search_dimension("strength_tolC", {0.25, 0.5});
+		add_search_dimension("distance_R", {1, 2});
+		add_search_dimension("relaxation_order", {std::make_pair(std::string("A"),std::string("FFF")),
+												  std::make_pair(std::string("A"),std::string("FFC"))});
+		break;
+	case BoomerAMGParameters::CLASSICAL_AMG:
+		//
+		// the classical defaults do not set the interpolation and strength threshold, add them with the hypre defaults
+		//
+		if (!base_parameters.has_parameter("interp_type"))
+			base_parameters.add_parameter("interp_type", BoomerAMGParameters::make_parameter_data(&HYPRE_BoomerAMGSetInterpType, 0));
+		if (!base_parameters.has_parameter("strength_tolC"))
+			base_parameters.add_parameter("strength_tolC", BoomerAMGParameters::make_parameter_data(&HYPRE_BoomerAMGSetStrongThreshold, 0.25));
+
+		add_search_dimension("coarsen_type", {6, 8, 10});
+		add_search_dimension("relax_type", {3, 6, 8});
+		add_search_dimension("interp_type", {0, 6});
+		add_search_dimension("strength_tolC", {0.25, 0.5});
+		break;
+	case BoomerAMGParameters::NONE:
+		break;
+	}
+
+}
+
+const BoomerAMGAutotuner::Candidate & BoomerAMGAutotuner::tune(const LinearAlgebraTrilinos::MPI::SparseMatrix & A,const LinearAlgebraTrilinos::MPI::Vector & b){
+
+	communicator = A.get_mpi_communicator();
+	candidates.clear();
+	//
+	// loop over the cartesian product of the search dimensions, index holds the position in each dimension
+	//
+	std::vector<unsigned int> index(search_space.size(), 0);
+
+	while (true){
+
+		Candidate candidate;
+		BoomerAMGParameters trial_parameters(base_parameters);
+
+		for (unsigned int d=0; d<search_space.size(); ++d){
+			candidate.values.push_back({search_space[d].first, search_space[d].second[index[d]]});
+			trial_parameters.set_parameter_value(search_space[d].first, search_space[d].second[index[d]]);
+		}
+
+		if (trial_parameters.has_parameter("max_itter"))
+			trial_parameters.set_parameter_value("max_itter", (int)additional_data.max_itter);
+		if (trial_parameters.has_parameter("solve_tol"))
+			trial_parameters.set_parameter_value("solve_tol", additional_data.solve_tol);
+		if (trial_parameters.has_parameter("hypre_print_level"))
+			trial_parameters.set_parameter_value("hypre_print_level", 0);
+
+		LinearAlgebraTrilinos::MPI::Vector x(b);
+		x = 0.0;
+
+		SolverBoomerAMG trial_solver(trial_parameters);
+		trial_solver.initialize(A);
+		trial_solver.solve(x,b);
+
+		candidate.statistics = trial_solver.get_statistics();
+		candidate.converged = candidate.statistics.final_residual <= additional_data.solve_tol;
+
+		candidates.push_back(candidate);
+
+		unsigned int d = 0;
+		for (; d<search_space.size(); ++d){
+			if (++index[d] < search_space[d].second.size())
+				break;
+			index[d] = 0;
+		}
+		if (d == search_space.size())
+			break;
+	}
+
+	std::stable_sort(candidates.begin(), candidates.end(),
+			[this](const Candidate & a, const Candidate & b){ return ranks_before(a,b); });
+
+	return get_best();
+
+}
+
+bool BoomerAMGAutotuner::ranks_before(const Candidate & a, const Candidate & b) const{
+
+	if (a.converged != b.converged)
+		return a.converged;
+
+	const double total_a = a.statistics.setup_time + a.statistics.solve_time;
+	const double total_b = b.statistics.setup_time + b.statistics.solve_time;
+
+	switch(additional_data.criterion)
+	{
+	case TIME_TO_TOLERANCE:
+		if (a.statistics.solve_time != b.statistics.solve_time)
+			return a.statistics.solve_time < b.statistics.solve_time;
+		break;
+	case MEMORY:
+		if (a.statistics.operator_complexity != b.statistics.operator_complexity)
+			return a.statistics.operator_complexity < b.statistics.operator_complexity;
+		break;
+	case SETUP_PLUS_SOLVE_TIME:
+		break;
+	}
+
+	return total_a < total_b;
+
+}
+
+const std::vector<BoomerAMGAutotuner::Candidate> & BoomerAMGAutotuner::get_ranked_candidates() const{
+
+	return candidates;
+
+}
+
+const BoomerAMGAutotuner::Candidate & BoomerAMGAutotuner::get_best() const{
+
+	AssertThrow(!candidates.empty(), ExcMessage("tune must be called before the best candidate is available."));
+
+	return candidates.front();
+
+}
+
+void BoomerAMGAutotuner::apply_best(BoomerAMGParameters & parameters) const{
+
+	for (const auto & value : get_best().values)
+		parameters.set_parameter_value(value.first, value.second);
+
+}
+
+void BoomerAMGAutotuner::save(const std::string & filename) const{
+
+	const Candidate & best = get_best();
+
+	if (Utilities::MPI::this_mpi_process(communicator) != 0)
+		return;
+
+	std::ofstream out(filename);
+	AssertThrow(out, ExcMessage("Could not open " + filename + " for writing."));
+
+	out << "# BoomerAMG parameters selected by BoomerAMGAutotuner\n";
+	out << "# setup_time " << best.statistics.setup_time
+		<< " solve_time " << best.statistics.solve_time
+		<< " n_iterations " << best.statistics.n_iterations
+		<< " operator_complexity " << best.statistics.operator_complexity << '\n';
+
+	for (const auto & value : best.values){
+		out << value.first << ' ';
+		ifpackHypreSolverPrecondParameters::write_parameter_value(out, value.second);
+		out << '\n';
+	}
+
+}
+
+bool BoomerAMGAutotuner::load(const std::string & filename,BoomerAMGParameters & parameters){
+
+	std::ifstream in(filename);
+
+	if (!in)
+		return false;
+
+	parameters.read_parameters(in);
+
+	return true;
+
+}
+
+}
+DEAL_II_NAMESPACE_CLOSE
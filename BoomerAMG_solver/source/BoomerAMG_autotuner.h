@@ -0,0 +1,191 @@
+#ifndef BoomerAMG_autotuner_h
+#define BoomerAMG_autotuner_h
+
+#include "BoomerAMG_solver.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+DEAL_II_NAMESPACE_OPEN
+
+namespace TrilinosWrappers {
+
+/**
+ * This class automates the choice of BoomerAMG parameters for a given problem. A search space is defined by listing candidate
+ * values for any number of entries of a BoomerAMGParameters object, e.g. coarsen_type, interp_type, relax_type, strength_tolC,
+ * distance_R or relaxation_order. tune() runs a short trial solve with SolverBoomerAMG for every combination of these values and
+ * measures the setup time, solve time, iteration count, final residual and operator complexity, the latter being a measure
+ * of the memory used by the hierarchy. The candidates are then ranked according to the selected criterion, with candidates
+ * that did not reach the tolerance ranked last.
+ *
+ * The best candidate can be copied into a parameter object with apply_best and written to a file with save, so that later
+ * runs on the same class of problems can load it with load instead of repeating the search:
+ * @code
+ * TrilinosWrappers::BoomerAMGParameters AMG_parameters(100, 1.e-8, TrilinosWrappers::BoomerAMGParameters::AIR_AMG);
+ * TrilinosWrappers::BoomerAMGAutotuner tuner(AMG_parameters);
+ * tuner.add_default_search_space(TrilinosWrappers::BoomerAMGParameters::AIR_AMG);
+ * tuner.tune(system_matrix, system_rhs);
+ * tuner.apply_best(AMG_parameters);
+ * tuner.save("air_parameters.txt");
+ * @endcode
+ *
+ * @ingroup TrilinosWrappers
+ */
+class BoomerAMGAutotuner{
+public:
+	typedef ifpackHypreSolverPrecondParameters::param_value_variant param_value_variant;
+
+	/**
+	 * Criteria by which the candidates are ranked
+	 */
+	enum ranking_criterion {
+		/**
+		 * Rank by the solve time needed to reach the tolerance
+		 */
+		TIME_TO_TOLERANCE,
+		/**
+		 * Rank by the sum of setup and solve time
+		 */
+		SETUP_PLUS_SOLVE_TIME,
+		/**
+		 * Rank by operator complexity, i.e. by the memory used by the hierarchy
+		 */
+		MEMORY
+	};
+
+	/**
+	 * Settings of the trial solves
+	 */
+	struct AdditionalData{
+		/**
+		 * Constructor.
+		 */
+		AdditionalData(const unsigned int max_itter = 50,
+					   const double solve_tol = 1.e-8,
+					   const ranking_criterion criterion = SETUP_PLUS_SOLVE_TIME)
+		:max_itter(max_itter),solve_tol(solve_tol),criterion(criterion){};
+		/**
+		 * Maximum number of BoomerAMG iterations of a trial solve
+		 */
+		unsigned int max_itter;
+		/**
+		 * Relative residual at which a trial solve counts as converged
+		 */
+		double solve_tol;
+		/**
+		 * Criterion used to rank the candidates
+		 */
+		ranking_criterion criterion;
+	};
+
+	/**
+	 * Measured performance of a single candidate parameter set
+	 */
+	struct Candidate{
+		/**
+		 * Values of the search dimensions defining this candidate
+		 */
+		std::vector<std::pair<std::string,param_value_variant>> values;
+		/**
+		 * Statistics of the trial solve
+		 */
+		ifpackHypreSolverBase::Statistics statistics;
+		/**
+		 * Whether the trial solve reached the tolerance
+		 */
+		bool converged = false;
+	};
+
+	/**
+	 * Constructor.
+	 * @param base_parameters are the parameters used for everything not in the search space. They must be set up for
+	 * use of BoomerAMG as a solver. A copy is made, @p base_parameters is not modified.
+	 * @param additional_data are the settings of the trial solves
+	 */
+	BoomerAMGAutotuner(const BoomerAMGParameters & base_parameters,
+					   const AdditionalData & additional_data = AdditionalData());
+
+	/**
+	 * Add the parameter @p name to the search space with the candidate values @p values. The parameter must exist in the
+	 * base parameters and the values must have the type stored there.
+	 */
+	void add_search_dimension(const std::string & name,
+							  const std::vector<param_value_variant> & values);
+
+	/**
+	 * Add a search space over coarsening, interpolation, relaxation and strength threshold suitable for @p config_selection
+	 */
+	void add_default_search_space(const BoomerAMGParameters::AMG_type config_selection);
+
+	/**
+	 * Run a trial solve of <tt>Ax=b</tt> for every candidate and rank the candidates. The trial solves start from a zero
+	 * initial guess. This function is collective. Returns the best candidate.
+	 */
+	const Candidate & tune(const LinearAlgebraTrilinos::MPI::SparseMatrix & A,
+						   const LinearAlgebraTrilinos::MPI::Vector & b);
+
+	/**
+	 * Return all candidates ranked from best to worst. tune() must have been called.
+	 */
+	const std::vector<Candidate> & get_ranked_candidates() const;
+
+	/**
+	 * Return the best candidate. tune() must have been called.
+	 */
+	const Candidate & get_best() const;
+
+	/**
+	 * Assign the values of the best candidate to @p parameters
+	 */
+	void apply_best(BoomerAMGParameters & parameters) const;
+
+	/**
+	 * Write the values of the best candidate to @p filename in the format of
+	 * ifpackHypreSolverPrecondParameters::write_parameters. Only the first process writes the file.
+	 */
+	void save(const std::string & filename) const;
+
+	/**
+	 * Read values written by save into @p parameters. Returns false if the file could not be opened.
+	 */
+	static bool load(const std::string & filename,
+					 BoomerAMGParameters & parameters);
+
+private:
+	/**
+	 * Return whether candidate @p a ranks before candidate @p b
+	 */
+	bool ranks_before(const Candidate & a, const Candidate & b) const;
+
+	/**
+	 * Copy of the parameters given to the constructor
+	 */
+	BoomerAMGParameters base_parameters;
+
+	/**
+	 * Settings of the trial solves
+	 */
+	AdditionalData additional_data;
+
+	/**
+	 * The search space, one entry per parameter
+	 */
+	std::vector<std::pair<std::string,std::vector<param_value_variant>>> search_space;
+
+	/**
+	 * The candidates ranked by the last call to tune()
+	 */
+	std::vector<Candidate> candidates;
+
+	/**
+	 * Communicator of the matrix given to tune()
+	 */
+	MPI_Comm communicator = MPI_COMM_SELF;
+
+};
+
+} // Close namespace TrilinosWrappers
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
@@ -0,0 +1,275 @@
+#include <BoomerAMG_parameter_cache.h>
+
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/mpi.h>
+
+#include <Epetra_CrsMatrix.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <sstream>
+
+DEAL_II_NAMESPACE_OPEN
+
+namespace TrilinosWrappers
+{
+
+
+MatrixFingerprint MatrixFingerprint::compute(const LinearAlgebraTrilinos::MPI::SparseMatrix & A){
+
+	const MPI_Comm communicator = A.get_mpi_communicator();
+
+	MatrixFingerprint fingerprint;
+	fingerprint.n_rows = A.m();
+	fingerprint.n_nonzeros = A.n_nonzero_elements();
+	//
+	// row length histogram and diagonal dominance from a single pass over the local rows
+	//
+	const Epetra_CrsMatrix & matrix = A.trilinos_matrix();
+	double n_dominant_rows = 0.0;
+
+	for (int row=0; row<matrix.NumMyRows(); ++row){
+
+		int n_entries;
+		double * values;
+		int * indices;
+		matrix.ExtractMyRowView(row, n_entries, values, indices);
+
+		unsigned int bin = 0;
+		while ((2<<bin) <= n_entries && bin+1 < n_histogram_bins)
+			++bin;
+		fingerprint.row_length_histogram[bin] += 1.0;
+
+		double diagonal = 0.0, off_diagonal = 0.0;
+		for (int k=0; k<n_entries; ++k){
+			if (matrix.GCID64(indices[k]) == matrix.GRID64(row))
+				diagonal += std::abs(values[k]);
+			else
+				off_diagonal += std::abs(values[k]);
+		}
+		if (diagonal >= off_diagonal)
+			n_dominant_rows += 1.0;
+	}
+
+	std::vector<double> histogram_sums(n_histogram_bins);
+	Utilities::MPI::sum(fingerprint.row_length_histogram, communicator, histogram_sums);
+	for (unsigned int bin=0; bin<n_histogram_bins; ++bin)
+		fingerprint.row_length_histogram[bin] = histogram_sums[bin]/fingerprint.n_rows;
+
+	fingerprint.diagonal_dominance = Utilities::MPI::sum(n_dominant_rows, communicator)/fingerprint.n_rows;
+	//
+	// asymmetry estimate from the action of A and A^T on a fixed vector
+	//
+	LinearAlgebraTrilinos::MPI::Vector x(A.locally_owned_domain_indices(), communicator);
+	LinearAlgebraTrilinos::MPI::Vector Ax(A.locally_owned_range_indices(), communicator);
+	LinearAlgebraTrilinos::MPI::Vector ATx(A.locally_owned_range_indices(), communicator);
+
+	for (const auto index : x.locally_owned_elements())
+		x(index) = 1.0 + 0.5*std::sin(index);
+	x.compress(VectorOperation::insert);
+
+	A.vmult(Ax, x);
+	A.Tvmult(ATx, x);
+
+	LinearAlgebraTrilinos::MPI::Vector difference(Ax);
+	difference -= ATx;
+	Ax += ATx;
+
+	const double sum_norm = Ax.l2_norm();
+	fingerprint.asymmetry = (sum_norm > 0.0) ? difference.l2_norm()/sum_norm : 0.0;
+
+	return fingerprint;
+
+}
+
+double MatrixFingerprint::distance(const MatrixFingerprint & other) const{
+
+	auto relative_difference = [](const double a, const double b){
+		return (a == b) ? 0.0 : std::abs(a-b)/std::max(std::abs(a), std::abs(b));
+	};
+
+	double histogram_distance = 0.0;
+	for (unsigned int bin=0; bin<n_histogram_bins; ++bin)
+		histogram_distance += std::abs(row_length_histogram[bin] - other.row_length_histogram[bin]);
+
+	return relative_difference(n_rows, other.n_rows)
+			+ relative_difference(double(n_nonzeros)/n_rows, double(other.n_nonzeros)/other.n_rows)
+			+ 0.5*histogram_distance
+			+ std::abs(asymmetry - other.asymmetry)
+			+ std::abs(diagonal_dominance - other.diagonal_dominance);
+
+}
+
+void MatrixFingerprint::write(std::ostream & out) const{
+
+	out << n_rows << ' ' << n_nonzeros;
+	for (const double fraction : row_length_histogram)
+		out << ' ' << fraction;
+	out << ' ' << asymmetry << ' ' << diagonal_dominance;
+
+}
+
+void MatrixFingerprint::read(std::istream & in){
+
+	in >> n_rows >> n_nonzeros;
+	for (double & fraction : row_length_histogram)
+		in >> fraction;
+	in >> asymmetry >> diagonal_dominance;
+
+	AssertThrow(!in.fail(), ExcMessage("Could not read a matrix fingerprint."));
+
+}
+
+BoomerAMGParameterCache::BoomerAMGParameterCache(const std::string & filename,const MPI_Comm & communicator,const double max_distance)
+:
+filename(filename),
+communicator(communicator),
+max_distance(max_distance)
+{
+	read();
+}
+
+bool BoomerAMGParameterCache::lookup(const MatrixFingerprint & fingerprint,BoomerAMGParameters & parameters) const{
+
+	const Entry * entry = find(fingerprint);
+
+	if (entry == nullptr)
+		return false;
+
+	std::istringstream in(entry->parameters);
+	parameters.read_parameters(in);
+
+	return true;
+
+}
+
+bool BoomerAMGParameterCache::lookup(const LinearAlgebraTrilinos::MPI::SparseMatrix & A,BoomerAMGParameters & parameters) const{
+
+	return lookup(MatrixFingerprint::compute(A), parameters);
+
+}
+
+void BoomerAMGParameterCache::store(const MatrixFingerprint & fingerprint,const BoomerAMGAutotuner::Candidate & candidate){
+
+	std::ostringstream values;
+	values.precision(17);
+	for (const auto & value : candidate.values){
+		values << value.first << ' ';
+		ifpackHypreSolverPrecondParameters::write_parameter_value(values, value.second);
+		values << '\n';
+	}
+
+	const Entry * existing = find(fingerprint);
+
+	if (existing == nullptr)
+		entries.push_back(Entry());
+
+	Entry & entry = (existing == nullptr) ? entries.back() : entries[existing - entries.data()];
+	entry.fingerprint = fingerprint;
+	entry.parameters = values.str();
+
+	write();
+
+}
+
+bool BoomerAMGParameterCache::lookup_or_tune(const LinearAlgebraTrilinos::MPI::SparseMatrix & A,const LinearAlgebraTrilinos::MPI::Vector & b,BoomerAMGAutotuner & tuner,BoomerAMGParameters & parameters){
+
+	const MatrixFingerprint fingerprint = MatrixFingerprint::compute(A);
+
+	if (lookup(fingerprint, parameters))
+		return true;
+
+	tuner.tune(A, b);
+	tuner.apply_best(parameters);
+	store(fingerprint, tuner.get_best());
+
+	return false;
+
+}
+
+unsigned int BoomerAMGParameterCache::n_entries() const{
+
+	return entries.size();
+
+}
+
+const BoomerAMGParameterCache::Entry * BoomerAMGParameterCache::find(const MatrixFingerprint & fingerprint) const{
+
+	const Entry * closest = nullptr;
+	double closest_distance = max_distance;
+
+	for (const auto & entry : entries){
+		const double distance = fingerprint.distance(entry.fingerprint);
+		if (distance <= closest_distance){
+			closest = &entry;
+			closest_distance = distance;
+		}
+	}
+
+	return closest;
+
+}
+
+void BoomerAMGParameterCache::read(){
+
+	entries.clear();
+
+	std::ifstream in(filename);
+	if (!in)
+		return;
+	//
+	// each entry is a fingerprint line followed by the parameter values and a closing end line
+	//
+	std::string line;
+	while (std::getline(in, line)){
+
+		std::istringstream line_stream(line);
+		std::string keyword;
+
+		if (!(line_stream >> keyword) || keyword != "fingerprint")
+			continue;
+
+		Entry entry;
+		entry.fingerprint.read(line_stream);
+
+		while (std::getline(in, line) && line != "end")
+			entry.parameters += line + '\n';
+
+		entries.push_back(entry);
+	}
+
+}
+
+void BoomerAMGParameterCache::write() const{
+
+	bool written = true;
+
+	if (Utilities::MPI::this_mpi_process(communicator) == 0){
+
+		std::ofstream out(filename);
+
+		out.precision(17);
+		out << "# BoomerAMG parameter cache written by BoomerAMGParameterCache\n";
+
+		for (const auto & entry : entries){
+			out << "fingerprint ";
+			entry.fingerprint.write(out);
+			out << '\n' << entry.parameters << "end\n";
+		}
+
+		out.close();
+		written = !out.fail();
+	}
+	//
+	// every process waits for the file, so that a lookup right after a store reads the new entry
+	//
+	written = (Utilities::MPI::min(written ? 1 : 0, communicator) == 1);
+	AssertThrow(written, ExcMessage("Could not write " + filename + "."));
+
+}
+
+}
+DEAL_II_NAMESPACE_CLOSE
@@ -0,0 +1,188 @@
+#ifndef BoomerAMG_parameter_cache_h
+#define BoomerAMG_parameter_cache_h
+
+#include "BoomerAMG_autotuner.h"
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+DEAL_II_NAMESPACE_OPEN
+
+namespace TrilinosWrappers {
+
+/**
+ * A cheap structural and numerical summary of a matrix, used to recognize recurring problems. It holds the size, the
+ * number of nonzeros, a histogram of the row lengths, an estimate of the asymmetry and the diagonal dominance. Computing
+ * it costs one pass over the local rows and two matrix vector products.
+ *
+ * @ingroup TrilinosWrappers
+ */
+struct MatrixFingerprint{
+	/**
+	 * Number of bins of the row length histogram. Bin k counts the rows with a length in [2^k, 2^(k+1)), empty rows are
+	 * counted in the first bin and the last bin is open ended.
+	 */
+	static const unsigned int n_histogram_bins = 8;
+
+	/**
+	 * Number of rows
+	 */
+	types::global_dof_index n_rows = 0;
+	/**
+	 * Number of nonzero entries
+	 */
+	types::global_dof_index n_nonzeros = 0;
+	/**
+	 * Fraction of the rows falling into each bin of the row length histogram
+	 */
+	std::vector<double> row_length_histogram = std::vector<double>(n_histogram_bins, 0.0);
+	/**
+	 * Estimate of the asymmetry, <tt>|(A-A^T)x| / |(A+A^T)x|</tt> for a fixed vector x. This is zero for a symmetric matrix.
+	 */
+	double asymmetry = 0.0;
+	/**
+	 * Fraction of the rows that are diagonally dominant
+	 */
+	double diagonal_dominance = 0.0;
+
+	/**
+	 * Compute the fingerprint of @p A. This function is collective.
+	 */
+	static MatrixFingerprint compute(const LinearAlgebraTrilinos::MPI::SparseMatrix & A);
+
+	/**
+	 * Return a measure of the difference between this fingerprint and @p other. The measure is zero for identical
+	 * fingerprints and sums the relative difference in size and average row length, half the L1 distance of the
+	 * histograms and the differences in asymmetry and diagonal dominance.
+	 */
+	double distance(const MatrixFingerprint & other) const;
+
+	/**
+	 * Write the fingerprint to @p out on a single line
+	 */
+	void write(std::ostream & out) const;
+
+	/**
+	 * Read a fingerprint written by write
+	 */
+	void read(std::istream & in);
+};
+
+/**
+ * A file backed cache of tuned BoomerAMG parameters. Each entry maps the MatrixFingerprint of a tuned matrix to the values
+ * selected by BoomerAMGAutotuner for it. lookup() finds the entry closest to the fingerprint of a new matrix and, if it is
+ * close enough, loads its values into a parameter object, so recurring problems start from the fastest known configuration
+ * without repeating the search:
+ * @code
+ * TrilinosWrappers::BoomerAMGParameters AMG_parameters(100, 1.e-8, TrilinosWrappers::BoomerAMGParameters::AIR_AMG);
+ * TrilinosWrappers::BoomerAMGAutotuner tuner(AMG_parameters);
+ * tuner.add_default_search_space(TrilinosWrappers::BoomerAMGParameters::AIR_AMG);
+ *
+ * TrilinosWrappers::BoomerAMGParameterCache cache("boomeramg_cache.txt", mpi_communicator);
+ * cache.lookup_or_tune(system_matrix, system_rhs, tuner, AMG_parameters);
+ * @endcode
+ *
+ * SolverBoomerAMG::set_parameter_cache makes the solver look up every matrix it is set up for, so a cache filled by a
+ * tuning run is used without further code in the caller.
+ *
+ * Every process reads the file, only the first process of the communicator writes it.
+ *
+ * @ingroup TrilinosWrappers
+ */
+class BoomerAMGParameterCache{
+public:
+	/**
+	 * Constructor. Reads the entries of @p filename if the file exists.
+	 * @param filename is the cache file
+	 * @param communicator is the communicator of the matrices looked up in the cache
+	 * @param max_distance is the largest MatrixFingerprint::distance for which an entry counts as a hit
+	 */
+	BoomerAMGParameterCache(const std::string & filename,
+							const MPI_Comm & communicator,
+							const double max_distance = 0.1);
+
+	/**
+	 * Load the entry closest to @p fingerprint into @p parameters. Returns false, and leaves @p parameters unchanged, if
+	 * no entry is within max_distance.
+	 */
+	bool lookup(const MatrixFingerprint & fingerprint,
+				BoomerAMGParameters & parameters) const;
+
+	/**
+	 * Same as above, with the fingerprint computed from @p A. This function is collective.
+	 */
+	bool lookup(const LinearAlgebraTrilinos::MPI::SparseMatrix & A,
+				BoomerAMGParameters & parameters) const;
+
+	/**
+	 * Store the values of @p candidate for @p fingerprint and write the cache file. An existing entry within max_distance
+	 * of @p fingerprint is replaced. This function is collective, it returns once the file is written.
+	 */
+	void store(const MatrixFingerprint & fingerprint,
+			   const BoomerAMGAutotuner::Candidate & candidate);
+
+	/**
+	 * Load the cached parameters for <tt>A</tt> into @p parameters. On a miss, run @p tuner on <tt>Ax=b</tt>, apply and store
+	 * the best candidate. Returns true on a cache hit. This function is collective.
+	 */
+	bool lookup_or_tune(const LinearAlgebraTrilinos::MPI::SparseMatrix & A,
+						const LinearAlgebraTrilinos::MPI::Vector & b,
+						BoomerAMGAutotuner & tuner,
+						BoomerAMGParameters & parameters);
+
+	/**
+	 * Return the number of entries in the cache
+	 */
+	unsigned int n_entries() const;
+
+private:
+	/**
+	 * A single cache entry. The values are kept in the format of ifpackHypreSolverPrecondParameters::write_parameters.
+	 */
+	struct Entry{
+		MatrixFingerprint fingerprint;
+		std::string parameters;
+	};
+
+	/**
+	 * Return the entry closest to @p fingerprint, or nullptr if no entry is within max_distance
+	 */
+	const Entry * find(const MatrixFingerprint & fingerprint) const;
+
+	/**
+	 * Read the entries from the cache file
+	 */
+	void read();
+
+	/**
+	 * Write all entries to the cache file
+	 */
+	void write() const;
+
+	/**
+	 * The cache file
+	 */
+	std::string filename;
+
+	/**
+	 * Communicator of the matrices looked up in the cache
+	 */
+	MPI_Comm communicator;
+
+	/**
+	 * Largest distance for which an entry counts as a hit
+	 */
+	double max_distance;
+
+	/**
+	 * The cached entries
+	 */
+	std::vector<Entry> entries;
+
+};
+
+} // Close namespace TrilinosWrappers
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
@@ -1,21 +1,154 @@
 
 #include <BoomerAMG_solver.h>
+#include <BoomerAMG_parameter_cache.h>
+
+#include <deal.II/base/timer.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/mpi.h>
+
+#include <_hypre_parcsr_ls.h>
+
+//
+// hypre has no public interface to the levels of a BoomerAMG hierarchy or to the grid_relax_points array a solver holds,
+// so both are accessed through hypre_ParAMGData. This is only compiled for the hypre releases it was checked against, 2.14
+// (the first release with AIR) up to the 2.x series. For other releases the hierarchy statistics stay zero and the
+// relaxation points are allocated for every setup and freed by hypre.
+//
+#if defined(HYPRE_RELEASE_NUMBER) && HYPRE_RELEASE_NUMBER >= 21400 && HYPRE_RELEASE_NUMBER < 30000
+#define BOOMERAMG_SOLVER_HYPRE_INTERNALS
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <sstream>
 
 DEAL_II_NAMESPACE_OPEN
 
 namespace TrilinosWrappers
 {
 
+namespace
+{
+	/**
+	 * Set function registered with Ifpack_Hypre::SetParameter to capture the hypre solver handle created by Ifpack_Hypre.
+	 * handle_storage points to the HYPRE_Solver the handle is written to. Only the public SetParameter interface is used:
+	 * Ifpack_Hypre passes the pointer through unchanged, and the cast merely undoes the one made when registering it.
+	 * Callers check that the handle was captured, so a change in Ifpack_Hypre fails loudly.
+	 */
+	int capture_solver_handle(HYPRE_Solver solver, int * handle_storage){
+		*reinterpret_cast<HYPRE_Solver *>(handle_storage) = solver;
+		return 0;
+	}
+
+	/**
+	 * Resets the flag marking an asynchronous solve as pending when it is destroyed. It is owned by the task stored in the
+	 * future returned by solve_async, so the flag is reset once the future has been read or destroyed, whether or not a
+	 * deferred task was ever run.
+	 */
+	struct async_solve_guard{
+		async_solve_guard(std::atomic<bool> & running):running(running){};
+		~async_solve_guard(){ running = false; }
+		std::atomic<bool> & running;
+	};
+
+#ifdef BOOMERAMG_SOLVER_HYPRE_INTERNALS
+	/**
+	 * The grid_relax_points arrays handed to hypre for the relaxation_order parameter. The arrays of a relaxation order are
+	 * built the first time it is used and kept for the lifetime of the program, so repeated setups allocate nothing.
+	 */
+	struct grid_relax_points_data{
+		std::vector<int> down;
+		std::vector<int> up;
+		std::vector<int> coarse;
+		int * points[4];
+	};
+
+	std::map<std::pair<std::string,std::string>, grid_relax_points_data> grid_relax_points_pool;
+	std::mutex grid_relax_points_mutex;
+#endif
+
+	/**
+	 * Convert a relaxation string such as FFC to the point types used by hypre
+	 */
+	std::vector<int> relaxation_point_types(const std::string & relaxation){
+
+		std::vector<int> point_types(relaxation.length());
+
+		for (unsigned int i=0; i<relaxation.length(); ++i){
+			switch(relaxation[i])
+			{
+			case 'F':
+				point_types[i] = -1;
+				break;
+			case 'C':
+				point_types[i] = 1;
+				break;
+			case 'A':
+				point_types[i] = 0;
+				break;
+			default:
+				AssertThrow(false, ExcMessage("A relaxation order may only contain the characters F, C and A, got " + relaxation));
+			}
+		}
+
+		return point_types;
+	}
+}
+
+
+void ifpackHypreSolverPrecondParameters::update_parameter_table(){
+
+	if (parameter_table_is_current)
+		return;
+
+	parameter_table.clear();
+	parameter_table.reserve(parameters.size());
+
+	for (auto param_itter=parameters.begin();param_itter!=parameters.end();++param_itter)
+		parameter_table.push_back(&(param_itter->second));
+
+	parameter_table_is_current = true;
+
+}
 
 void ifpackHypreSolverPrecondParameters::set_parameters(Ifpack_Hypre & Ifpack_obj){
 
+	update_parameter_table();
+
 	apply_parameter_variant_visitor parameter_visitor(Ifpack_obj, solver_preconditioner_selection);
 
-	for (auto param_itter=parameters.begin();param_itter!=parameters.end();++param_itter){
-		if ((param_itter->second).set_function == nullptr){
-			boost::apply_visitor(parameter_visitor, (param_itter->second).hypre_function, (param_itter->second).value );
+	for (const parameter_data * param : parameter_table){
+		if (param->typed_set_function != nullptr){
+			param->typed_set_function(*param, Ifpack_obj, solver_preconditioner_selection);
+		} else if (param->set_function == nullptr){
+			parameter_data & param_data = const_cast<parameter_data &>(*param);
+			boost::apply_visitor(parameter_visitor, param_data.hypre_function, param_data.value );
+		} else{
+			param->set_function(solver_preconditioner_selection, *param , Ifpack_obj);
+		}
+	}
+}
+
+
+void ifpackHypreSolverPrecondParameters::set_parameters(HYPRE_Solver solver){
+
+	update_parameter_table();
+
+	apply_hypre_parameter_variant_visitor parameter_visitor(solver);
+
+	for (const parameter_data * param : parameter_table){
+		if (param->typed_native_set_function != nullptr){
+			param->typed_native_set_function(*param, solver);
+		} else if (param->set_function == nullptr){
+			parameter_data & param_data = const_cast<parameter_data &>(*param);
+			boost::apply_visitor(parameter_visitor, param_data.hypre_function, param_data.value );
 		} else{
-			(param_itter->second).set_function(solver_preconditioner_selection, param_itter->second , Ifpack_obj);
+			AssertThrow(param->native_set_function != nullptr,
+					ExcMessage("A parameter with a custom set function can only be set through Ifpack_Hypre."));
+			param->native_set_function(*param , solver);
 		}
 	}
 }
@@ -26,6 +159,7 @@ void ifpackHypreSolverPrecondParameters::set_parameter_value(const std::string n
 	auto it = parameters.find(name);
 
 	AssertThrow(it!=parameters.end(), ExcMessage("When using set_parameter_value, the parameter must already be present in the parameters map."));
+	AssertThrow((it->second).value.which()==value.which(), ExcMessage("When using set_parameter_value, the type of the value must match the type of the value already stored for " + name + "."));
 
 	(it->second).value = value;
 }
@@ -37,6 +171,7 @@ void ifpackHypreSolverPrecondParameters::add_parameter(const std::string name,co
 	AssertThrow(it==parameters.end(), ExcMessage("When using add_parameter, the parameter name should not already exist."));
 
 	parameters.insert({name, param_data});
+	parameter_table_is_current = false;
 
 }
 
@@ -44,10 +179,151 @@ void ifpackHypreSolverPrecondParameters::remove_parameter(const std::string name
 
 	auto it = parameters.find(name);
 
-	if (it!=parameters.end())
+	if (it!=parameters.end()){
 		parameters.erase(it);
+		parameter_table_is_current = false;
+	}
+
+}
+ifpackHypreSolverPrecondParameters::param_value_variant ifpackHypreSolverPrecondParameters::get_parameter_value(const std::string name) const{
+
+	auto it = parameters.find(name);
+
+	AssertThrow(it!=parameters.end(), ExcMessage("The parameter " + name + " does not exist."));
+
+	return (it->second).value;
+
+}
+
+bool ifpackHypreSolverPrecondParameters::has_parameter(const std::string name) const{
+
+	return parameters.find(name)!=parameters.end();
+
+}
+
+std::string ifpackHypreSolverPrecondParameters::parameter_type_name(const param_value_variant & value){
+
+	return boost::apply_visitor(type_name_visitor(), value);
+
+}
+
+void ifpackHypreSolverPrecondParameters::write_parameter_value(std::ostream & out, const param_value_variant & value){
+
+	const std::string type = parameter_type_name(value);
+
+	AssertThrow(!type.empty(), ExcMessage("Parameter values holding pointers cannot be written."));
+	//
+	// doubles are written with enough digits to be read back exactly, the precision of the caller's stream is restored
+	//
+	const std::streamsize precision = out.precision(17);
+
+	out << type << ' ';
+	boost::apply_visitor(write_value_visitor(out), value);
+
+	out.precision(precision);
+
+}
+
+ifpackHypreSolverPrecondParameters::param_value_variant ifpackHypreSolverPrecondParameters::read_parameter_value(std::istream & in){
+
+	auto read_string = [&in](){ std::string str; in >> str; return (str == "-") ? std::string() : str; };
+
+	std::string type;
+	in >> type;
+
+	param_value_variant value;
+
+	if (type == "int"){
+		int v; in >> v; value = v;
+	} else if (type == "double"){
+		double v; in >> v; value = v;
+	} else if (type == "pair_double_int"){
+		std::pair<double,int> v; in >> v.first >> v.second; value = v;
+	} else if (type == "pair_int_int"){
+		std::pair<int,int> v; in >> v.first >> v.second; value = v;
+	} else if (type == "pair_string_string"){
+		std::pair<std::string,std::string> v;
+		v.first = read_string();
+		v.second = read_string();
+		value = v;
+	} else{
+		AssertThrow(false, ExcMessage("Unknown parameter value type " + type));
+	}
+
+	AssertThrow(!in.fail(), ExcMessage("Could not read a parameter value of type " + type));
+
+	return value;
+
+}
+
+void ifpackHypreSolverPrecondParameters::write_parameters(std::ostream & out) const{
+
+	for (auto param_itter=parameters.begin();param_itter!=parameters.end();++param_itter){
+
+		if (parameter_type_name((param_itter->second).value).empty())
+			continue;
+
+		out << param_itter->first << ' ';
+		write_parameter_value(out, (param_itter->second).value);
+		out << '\n';
+	}
 
 }
+
+unsigned int ifpackHypreSolverPrecondParameters::read_parameters(std::istream & in){
+
+	unsigned int n_assigned = 0;
+	std::string line;
+
+	while (std::getline(in, line)){
+
+		std::istringstream line_stream(line);
+		std::string name;
+
+		if (!(line_stream >> name) || name[0] == '#')
+			continue;
+
+		const param_value_variant value = read_parameter_value(line_stream);
+
+		if (has_parameter(name)){
+			set_parameter_value(name, value);
+			++n_assigned;
+		}
+	}
+
+	return n_assigned;
+
+}
+
+unsigned int ifpackHypreSolverPrecondParameters::set_parameter_values(const std::string & assignments){
+
+	unsigned int n_assigned = 0;
+
+	for (const auto & assignment : Utilities::split_string_list(assignments, ';')){
+
+		if (assignment.empty())
+			continue;
+
+		const std::string::size_type equal_sign = assignment.find('=');
+		AssertThrow(equal_sign != std::string::npos, ExcMessage("Expected name = value, got " + assignment));
+
+		const std::string name = Utilities::trim(assignment.substr(0, equal_sign));
+		AssertThrow(has_parameter(name), ExcMessage("The parameter " + name + " does not exist."));
+		//
+		// prefix the value with the name of the stored type and read it as written by write_parameter_value
+		//
+		const std::string type = parameter_type_name(get_parameter_value(name));
+		AssertThrow(!type.empty(), ExcMessage("The parameter " + name + " holds a pointer and cannot be set from text."));
+
+		std::istringstream value_stream(type + ' ' + assignment.substr(equal_sign+1));
+		set_parameter_value(name, read_parameter_value(value_stream));
+		++n_assigned;
+	}
+
+	return n_assigned;
+
+}
+
 /**
  * TODO:: Make this const function because should not modify anything, only return value
  * @param name
@@ -70,13 +346,171 @@ ifpackHypreSolverPrecondParameters(Hypre_Chooser::Solver)
 	switch(solver_selection)
 	{
 	case Hypre_Solver::PCG:
-		parameters.insert( {"pcg_convergence_tol", parameter_data(solv_tol, & HYPRE_ParCSRPCGSetTol)} );
-		parameters.insert({"pcg_max_itter", parameter_data((int)max_itter,&HYPRE_ParCSRPCGSetMaxIter)});
-		parameters.insert({"pcg_print_level", parameter_data(3,&HYPRE_ParCSRPCGSetPrintLevel)});
+		parameters.insert( {"pcg_convergence_tol", make_parameter_data(&HYPRE_ParCSRPCGSetTol, solv_tol)} );
+		parameters.insert({"pcg_max_itter", make_parameter_data(&HYPRE_ParCSRPCGSetMaxIter, (int)max_itter)});
+		parameters.insert({"pcg_print_level", make_parameter_data(&HYPRE_ParCSRPCGSetPrintLevel, 3)});
 		break;
+	case Hypre_Solver::GMRES:
+		parameters.insert( {"gmres_convergence_tol", make_parameter_data(&HYPRE_ParCSRGMRESSetTol, solv_tol)} );
+		parameters.insert( {"gmres_max_itter", make_parameter_data(&HYPRE_ParCSRGMRESSetMaxIter, (int)max_itter)} );
+		parameters.insert( {"gmres_restart", make_parameter_data(&HYPRE_ParCSRGMRESSetKDim, 30)} );
+		parameters.insert( {"gmres_print_level", make_parameter_data(&HYPRE_ParCSRGMRESSetPrintLevel, 3)} );
+		break;
+	case Hypre_Solver::FlexGMRES:
+		parameters.insert( {"flexgmres_convergence_tol", make_parameter_data(&HYPRE_ParCSRFlexGMRESSetTol, solv_tol)} );
+		parameters.insert( {"flexgmres_max_itter", make_parameter_data(&HYPRE_ParCSRFlexGMRESSetMaxIter, (int)max_itter)} );
+		parameters.insert( {"flexgmres_restart", make_parameter_data(&HYPRE_ParCSRFlexGMRESSetKDim, 30)} );
+		parameters.insert( {"flexgmres_print_level", make_parameter_data(&HYPRE_ParCSRFlexGMRESSetPrintLevel, 3)} );
+		break;
+	case Hypre_Solver::LGMRES:
+		parameters.insert( {"lgmres_convergence_tol", make_parameter_data(&HYPRE_ParCSRLGMRESSetTol, solv_tol)} );
+		parameters.insert( {"lgmres_max_itter", make_parameter_data(&HYPRE_ParCSRLGMRESSetMaxIter, (int)max_itter)} );
+		parameters.insert( {"lgmres_restart", make_parameter_data(&HYPRE_ParCSRLGMRESSetKDim, 30)} );
+		parameters.insert( {"lgmres_augmentation_dim", make_parameter_data(&HYPRE_ParCSRLGMRESSetAugDim, 2)} );
+		parameters.insert( {"lgmres_print_level", make_parameter_data(&HYPRE_ParCSRLGMRESSetPrintLevel, 3)} );
+		break;
+	case Hypre_Solver::BiCGSTAB:
+		parameters.insert( {"bicgstab_convergence_tol", make_parameter_data(&HYPRE_ParCSRBiCGSTABSetTol, solv_tol)} );
+		parameters.insert( {"bicgstab_max_itter", make_parameter_data(&HYPRE_ParCSRBiCGSTABSetMaxIter, (int)max_itter)} );
+		parameters.insert( {"bicgstab_print_level", make_parameter_data(&HYPRE_ParCSRBiCGSTABSetPrintLevel, 3)} );
+		break;
+	default:
+		AssertThrow(false, ExcMessage("ifpackSolverParameters only supports the hypre Krylov solvers PCG, GMRES, FlexGMRES, LGMRES and BiCGSTAB."));
 	}
 }
 
+std::string ifpackSolverParameters::parameter_prefix() const{
+
+	switch(solver_selection)
+	{
+	case Hypre_Solver::PCG:
+		return "pcg_";
+	case Hypre_Solver::GMRES:
+		return "gmres_";
+	case Hypre_Solver::FlexGMRES:
+		return "flexgmres_";
+	case Hypre_Solver::LGMRES:
+		return "lgmres_";
+	case Hypre_Solver::BiCGSTAB:
+		return "bicgstab_";
+	default:
+		return "";
+	}
+
+}
+
+void ifpackSolverParameters::set_tolerance(const double solv_tol){
+
+	set_parameter_value(parameter_prefix() + "convergence_tol", solv_tol);
+
+}
+
+void ifpackSolverParameters::set_max_iterations(const unsigned int max_itter){
+
+	set_parameter_value(parameter_prefix() + "max_itter", (int)max_itter);
+
+}
+
+void ifpackSolverParameters::set_restart(const unsigned int restart){
+
+	const std::string name = parameter_prefix() + "restart";
+
+	AssertThrow(has_parameter(name), ExcMessage("A restart length can only be set for GMRES, FlexGMRES and LGMRES."));
+
+	set_parameter_value(name, (int)restart);
+
+}
+
+void ifpackSolverParameters::set_print_level(const int print_level){
+
+	set_parameter_value(parameter_prefix() + "print_level", print_level);
+
+}
+
+int** BoomerAMGParameters::get_grid_relax_points(const std::pair<std::string,std::string> & param_value){
+
+#ifdef BOOMERAMG_SOLVER_HYPRE_INTERNALS
+	std::lock_guard<std::mutex> lock(grid_relax_points_mutex);
+
+	auto pool_entry = grid_relax_points_pool.find(param_value);
+
+	if (pool_entry == grid_relax_points_pool.end()){
+
+		grid_relax_points_data data;
+		data.down = relaxation_point_types(param_value.first);
+		data.up = relaxation_point_types(param_value.second);
+		data.coarse = std::vector<int>(1, 0);
+
+		pool_entry = grid_relax_points_pool.insert({param_value, data}).first;
+		//
+		// the vectors have been copied into the map, so the pointers are taken from the stored entry
+		//
+		grid_relax_points_data & stored_data = pool_entry->second;
+		stored_data.points[0] = nullptr;
+		stored_data.points[1] = stored_data.down.data();
+		stored_data.points[2] = stored_data.up.data();
+		stored_data.points[3] = stored_data.coarse.data();
+	}
+
+	return pool_entry->second.points;
+#else
+	//
+	// a pooled array could not be detached before hypre frees it, so the arrays are allocated by hypre and owned by it
+	//
+	const std::vector<int> point_types[3] = {relaxation_point_types(param_value.first),
+											 relaxation_point_types(param_value.second),
+											 std::vector<int>(1, 0)};
+
+	int ** points = hypre_CTAlloc(int *, 4, HYPRE_MEMORY_HOST);
+	points[0] = nullptr;
+	for (unsigned int cycle=0; cycle<3; ++cycle){
+		points[cycle+1] = hypre_CTAlloc(int, point_types[cycle].size(), HYPRE_MEMORY_HOST);
+		std::copy(point_types[cycle].begin(), point_types[cycle].end(), points[cycle+1]);
+	}
+
+	return points;
+#endif
+
+}
+
+int BoomerAMGParameters::set_grid_relax_points(HYPRE_Solver solver, int** grid_relax_points){
+	//
+	// hypre frees the array it currently holds, so a pooled array set by an earlier call must be detached first
+	//
+	release_grid_relax_points(solver);
+
+	return HYPRE_BoomerAMGSetGridRelaxPoints(solver, grid_relax_points);
+
+}
+
+void BoomerAMGParameters::release_grid_relax_points(HYPRE_Solver amg_solver){
+
+#ifdef BOOMERAMG_SOLVER_HYPRE_INTERNALS
+	if (amg_solver == nullptr)
+		return;
+
+	hypre_ParAMGData * amg_data = (hypre_ParAMGData *) amg_solver;
+	const void * grid_relax_points = hypre_ParAMGDataGridRelaxPoints(amg_data);
+
+	if (grid_relax_points == nullptr)
+		return;
+
+	std::lock_guard<std::mutex> lock(grid_relax_points_mutex);
+
+	for (const auto & pool_entry : grid_relax_points_pool)
+		if (grid_relax_points == static_cast<const void *>(pool_entry.second.points)){
+			hypre_ParAMGDataGridRelaxPoints(amg_data) = nullptr;
+			return;
+		}
+#else
+	//
+	// the arrays are owned by hypre, see get_grid_relax_points
+	//
+	(void) amg_solver;
+#endif
+
+}
+
 void BoomerAMGParameters::set_relaxation_order(const Hypre_Chooser solver_preconditioner_selection, const parameter_data & param_data, Ifpack_Hypre & Ifpack_obj){
 
 	std::pair<std::string,std::string> param_value = boost::get< std::pair<std::string,std::string> >(param_data.value);
@@ -84,67 +518,48 @@ void BoomerAMGParameters::set_relaxation_order(const Hypre_Chooser solver_precon
 	const unsigned int ns_down = param_value.first.length();
 	const unsigned int ns_up = param_value.second.length();
 	const unsigned int ns_coarse = 1 ;
-	//
-	// hypre will free this memory
-	//
-	int** grid_relax_points = new int*[4];
-	//
-	grid_relax_points[0] = NULL;
-	grid_relax_points[1] = new int [ns_down];
-	grid_relax_points[2] = new int [ns_up];
-	grid_relax_points[3] = new int [1];
-	grid_relax_points[3][0] = 0;
-
-	// set down relax scheme
-	for(unsigned int i = 0; i<ns_down; i++) {
-	    if (param_value.first.compare(i,1,"F") == 0) {
-	       grid_relax_points[1][i] = -1;
-	    }
-	    else if (param_value.first.compare(i,1,"C") == 0) {
-	       grid_relax_points[1][i] = 1;
-	    }
-	    else if (param_value.first.compare(i,1,"A") == 0) {
-	       grid_relax_points[1][i] = 0;
-	    }
-	 }
-
-	 // set up relax scheme
-	 for(unsigned int i = 0; i<ns_up; i++) {
-	    if (param_value.second.compare(i,1,"F") == 0) {
-	       grid_relax_points[2][i] = -1;
-	    }
-	    else if (param_value.second.compare(i,1,"C") == 0) {
-	       grid_relax_points[2][i] = 1;
-	    }
-	    else if (param_value.second.compare(i,1,"A") == 0) {
-	       grid_relax_points[2][i] = 0;
-	    }
-	 }
-
-	Ifpack_obj.SetParameter(solver_preconditioner_selection , & HYPRE_BoomerAMGSetGridRelaxPoints , grid_relax_points);
+
+	int** grid_relax_points = get_grid_relax_points(param_value);
+
+	Ifpack_obj.SetParameter(solver_preconditioner_selection , & set_grid_relax_points , grid_relax_points);
 	Ifpack_obj.SetParameter(solver_preconditioner_selection , & HYPRE_BoomerAMGSetCycleNumSweeps , ns_coarse,3);
 	Ifpack_obj.SetParameter(solver_preconditioner_selection , & HYPRE_BoomerAMGSetCycleNumSweeps , ns_down,1);
 	Ifpack_obj.SetParameter(solver_preconditioner_selection , & HYPRE_BoomerAMGSetCycleNumSweeps , ns_up,2);
 
 }
 
+void BoomerAMGParameters::set_relaxation_order_native(const parameter_data & param_data, HYPRE_Solver solver){
+
+	std::pair<std::string,std::string> param_value = boost::get< std::pair<std::string,std::string> >(param_data.value);
+
+	const unsigned int ns_down = param_value.first.length();
+	const unsigned int ns_up = param_value.second.length();
+	const unsigned int ns_coarse = 1 ;
+
+	set_grid_relax_points(solver, get_grid_relax_points(param_value));
+	HYPRE_BoomerAMGSetCycleNumSweeps(solver, ns_coarse, 3);
+	HYPRE_BoomerAMGSetCycleNumSweeps(solver, ns_down, 1);
+	HYPRE_BoomerAMGSetCycleNumSweeps(solver, ns_up, 2);
+
+}
+
 
 BoomerAMGParameters::BoomerAMGParameters(const AMG_type config_selection)
 :ifpackHypreSolverPrecondParameters(Hypre_Chooser::Preconditioner)
 {
 	set_common_AMG_parameters(config_selection);
-	parameters.insert( {"hypre_print_level", parameter_data(1, & HYPRE_BoomerAMGSetPrintLevel)} );
-	parameters.insert( {"solve_tol", parameter_data(0.0, & HYPRE_BoomerAMGSetTol)} );
-	parameters.insert( {"max_itter", parameter_data(1, & HYPRE_BoomerAMGSetMaxIter)} );
+	parameters.insert( {"hypre_print_level", make_parameter_data(&HYPRE_BoomerAMGSetPrintLevel, 1)} );
+	parameters.insert( {"solve_tol", make_parameter_data(&HYPRE_BoomerAMGSetTol, 0.0)} );
+	parameters.insert( {"max_itter", make_parameter_data(&HYPRE_BoomerAMGSetMaxIter, 1)} );
 }
 
 BoomerAMGParameters::BoomerAMGParameters(const unsigned int max_itter,const double solv_tol,const AMG_type config_selection)
 :ifpackHypreSolverPrecondParameters(Hypre_Chooser::Solver)
 {
 	set_common_AMG_parameters(config_selection);
-	parameters.insert( {"hypre_print_level", parameter_data(3, & HYPRE_BoomerAMGSetPrintLevel)} );
-	parameters.insert( {"solve_tol", parameter_data(solv_tol, & HYPRE_BoomerAMGSetTol)} );
-	parameters.insert( {"max_itter", parameter_data((int)max_itter, & HYPRE_BoomerAMGSetMaxIter)} );
+	parameters.insert( {"hypre_print_level", make_parameter_data(&HYPRE_BoomerAMGSetPrintLevel, 3)} );
+	parameters.insert( {"solve_tol", make_parameter_data(&HYPRE_BoomerAMGSetTol, solv_tol)} );
+	parameters.insert( {"max_itter", make_parameter_data(&HYPRE_BoomerAMGSetMaxIter, (int)max_itter)} );
 }
 
 void BoomerAMGParameters::set_common_AMG_parameters(const AMG_type config_selection){
@@ -152,28 +567,28 @@ void BoomerAMGParameters::set_common_AMG_parameters(const AMG_type config_select
 	{
 	case AIR_AMG:
 	{
-		parameters.insert( {"interp_type", parameter_data(100, & HYPRE_BoomerAMGSetInterpType)} );
-		parameters.insert( {"coarsen_type", parameter_data(6, & HYPRE_BoomerAMGSetCoarsenType)} );
-		parameters.insert( {"relax_type", parameter_data(0, & HYPRE_BoomerAMGSetRelaxType)} );
-		parameters.insert( {"max_amg_levels", parameter_data(40, & HYPRE_BoomerAMGSetMaxLevels)} );
-		parameters.insert( {"sabs_flag", parameter_data(1, & HYPRE_BoomerAMGSetSabs)} );
-
-		parameters.insert( {"distance_R", parameter_data(2.0, & HYPRE_BoomerAMGSetRestriction)} );
-		parameters.insert( {"strength_tolC", parameter_data(0.25, & HYPRE_BoomerAMGSetStrongThreshold)} );
-		parameters.insert( {"strength_tolR", parameter_data(0.1, & HYPRE_BoomerAMGSetStrongThresholdR)} );
-		parameters.insert( {"filterA_tol", parameter_data(1.0e-4, & HYPRE_BoomerAMGSetADropTol)} );
-		parameters.insert( {"post_filter_R", parameter_data(0.0, & HYPRE_BoomerAMGSetFilterThresholdR)} );
+		parameters.insert( {"interp_type", make_parameter_data(&HYPRE_BoomerAMGSetInterpType, 100)} );
+		parameters.insert( {"coarsen_type", make_parameter_data(&HYPRE_BoomerAMGSetCoarsenType, 6)} );
+		parameters.insert( {"relax_type", make_parameter_data(&HYPRE_BoomerAMGSetRelaxType, 0)} );
+		parameters.insert( {"max_amg_levels", make_parameter_data(&HYPRE_BoomerAMGSetMaxLevels, 40)} );
+		parameters.insert( {"sabs_flag", make_parameter_data(&HYPRE_BoomerAMGSetSabs, 1)} );
+
+		parameters.insert( {"distance_R", make_parameter_data(&HYPRE_BoomerAMGSetRestriction, 2)} );
+		parameters.insert( {"strength_tolC", make_parameter_data(&HYPRE_BoomerAMGSetStrongThreshold, 0.25)} );
+		parameters.insert( {"strength_tolR", make_parameter_data(&HYPRE_BoomerAMGSetStrongThresholdR, 0.1)} );
+		parameters.insert( {"filterA_tol", make_parameter_data(&HYPRE_BoomerAMGSetADropTol, 1.0e-4)} );
+		parameters.insert( {"post_filter_R", make_parameter_data(&HYPRE_BoomerAMGSetFilterThresholdR, 0.0)} );
 
 		std::pair<std::string,std::string> relaxation_order("A","FFF");
 
-		parameters.insert( {"relaxation_order", parameter_data( relaxation_order, &set_relaxation_order )} );
+		parameters.insert( {"relaxation_order", parameter_data( relaxation_order, &set_relaxation_order, &set_relaxation_order_native )} );
 
 		break;
 	}
 	case CLASSICAL_AMG:
-		parameters.insert( {"coarsen_type", parameter_data(6, & HYPRE_BoomerAMGSetCoarsenType)} );
-		parameters.insert( {"relax_type", parameter_data(6, & HYPRE_BoomerAMGSetRelaxType)} );
-		parameters.insert( {"max_amg_levels", parameter_data(40, & HYPRE_BoomerAMGSetMaxLevels)} );
+		parameters.insert( {"coarsen_type", make_parameter_data(&HYPRE_BoomerAMGSetCoarsenType, 6)} );
+		parameters.insert( {"relax_type", make_parameter_data(&HYPRE_BoomerAMGSetRelaxType, 6)} );
+		parameters.insert( {"max_amg_levels", make_parameter_data(&HYPRE_BoomerAMGSetMaxLevels, 40)} );
 
 		break;
 	case NONE:
@@ -181,10 +596,556 @@ void BoomerAMGParameters::set_common_AMG_parameters(const AMG_type config_select
 	}
 }
 
-void SolverBoomerAMG::solve(LinearAlgebraTrilinos::MPI::SparseMatrix & A,LinearAlgebraTrilinos::MPI::Vector & x,LinearAlgebraTrilinos::MPI::Vector &b){
+void ifpackHypreSolverBase::initialize(const LinearAlgebraTrilinos::MPI::SparseMatrix & A){
+
+	assert_no_pending_async_solve();
+
+	if (reuse_parameters.reuse_setup && is_initialized() &&
+		system_matrix->m()==A.m() && system_matrix->local_size()==A.local_size()){
+		//
+		// keep the hierarchy computed for the previous matrix
+		//
+		system_matrix = &A;
+		setup_is_stale = true;
+		return;
+	}
+
+	setup(A);
+
+}
+
+void ifpackHypreSolverBase::setup(const LinearAlgebraTrilinos::MPI::SparseMatrix & A){
+	//
+	// A may be a matrix kept alive for an asynchronous solve, e.g. on a new setup for a stale hierarchy. clear() releases
+	// those matrices, so the owner of A is held over the call and keeps owning it as the matrix of the new setup.
+	//
+	std::shared_ptr<const LinearAlgebraTrilinos::MPI::SparseMatrix> matrix_owner;
+	if (async_matrix.get() == &A)
+		matrix_owner = async_matrix;
+	else if (async_setup_matrix.get() == &A)
+		matrix_owner = async_setup_matrix;
+
+	clear();
+
+	async_matrix = matrix_owner;
+	async_setup_matrix = matrix_owner;
+	system_matrix = &A;
 
 	Epetra_CrsMatrix * sys_matrix_pt=const_cast<Epetra_CrsMatrix *>(&A.trilinos_matrix());
-	Ifpack_Hypre hypre_interface( sys_matrix_pt );
+	hypre_interface.reset(new Ifpack_Hypre( sys_matrix_pt ));
+
+	statistics_communicator = A.get_mpi_communicator();
+
+	Timer parameter_timer;
+	set_parameters(*hypre_interface);
+	hypre_interface->SetParameter(Hypre_Chooser::Solver, &capture_solver_handle, reinterpret_cast<int *>(&solver_handle));
+	if (has_amg_preconditioner())
+		hypre_interface->SetParameter(Hypre_Chooser::Preconditioner, &capture_solver_handle, reinterpret_cast<int *>(&preconditioner_handle));
+	parameter_timer.stop();
+	statistics.parameter_time += parameter_timer.wall_time();
+
+	Timer conversion_timer;
+	int ierr = hypre_interface->Initialize();
+	conversion_timer.stop();
+	AssertThrow(ierr == 0, ExcMessage("Ifpack_Hypre::Initialize returned error code " + std::to_string(ierr)));
+	statistics.conversion_time += conversion_timer.wall_time();
+
+	Timer setup_timer;
+	ierr = hypre_interface->Compute();
+	setup_timer.stop();
+	AssertThrow(ierr == 0, ExcMessage("Ifpack_Hypre::Compute returned error code " + std::to_string(ierr)));
+	statistics.setup_time += setup_timer.wall_time();
+
+	++n_full_setups;
+	++statistics.n_setups;
+
+	AssertThrow(solver_handle != nullptr && (!has_amg_preconditioner() || preconditioner_handle != nullptr),
+			ExcMessage("Ifpack_Hypre did not apply the set function capturing its hypre handles."));
+
+	if (get_solver_type() == Hypre_Solver::BoomerAMG)
+		amg_handle = solver_handle;
+	else if (has_amg_preconditioner())
+		amg_handle = preconditioner_handle;
+
+	update_hierarchy_statistics(amg_handle);
+
+	update_memory_statistics();
+
+}
+
+void ifpackHypreSolverBase::set_reuse_parameters(const ReuseParameters & parameters){
+
+	reuse_parameters = parameters;
+
+}
+
+unsigned int ifpackHypreSolverBase::n_setups() const{
+
+	return n_full_setups;
+
+}
+
+void ifpackHypreSolverBase::solve(LinearAlgebraTrilinos::MPI::Vector & x,const LinearAlgebraTrilinos::MPI::Vector &b){
+
+	assert_no_pending_async_solve();
+	AssertThrow(is_initialized(), ExcMessage("initialize must be called before solve(x,b)."));
+
+	if (setup_is_stale){
+		if (solve_with_frozen_setup(x,b))
+			return;
+		//
+		// the frozen hierarchy is no longer good enough for the current matrix
+		//
+		setup(*system_matrix);
+	}
+
+	if (convergence_monitor.callback){
+		solve_monitored(x,b);
+		return;
+	}
+
+	if (x.linfty_norm() == 0.0){
+		apply_inverse(b.trilinos_vector(),x.trilinos_vector());
+		return;
+	}
+	//
+	// Ifpack_Hypre::ApplyInverse zeroes its result before calling hypre, so the initial guess enters through the residual
+	//
+	LinearAlgebraTrilinos::MPI::Vector residual(b);
+	LinearAlgebraTrilinos::MPI::Vector correction(b);
+
+	system_matrix->residual(residual,x,b);
+	correction = 0.0;
+	apply_inverse(residual.trilinos_vector(),correction.trilinos_vector());
+	x += correction;
+
+}
+
+void ifpackHypreSolverBase::solve_monitored(LinearAlgebraTrilinos::MPI::Vector & x,const LinearAlgebraTrilinos::MPI::Vector &b){
+
+	LinearAlgebraTrilinos::MPI::Vector residual(b);
+	LinearAlgebraTrilinos::MPI::Vector correction(b);
+
+	const double b_norm = b.l2_norm();
+	const double scaling = (b_norm > 0.0) ? 1.0/b_norm : 1.0;
+
+	convergence_history.clear();
+	convergence_history.push_back(system_matrix->residual(residual,x,b)*scaling);
+	monitor_stopped_solve = false;
+
+	const unsigned int n_solves = statistics.n_solves;
+	unsigned int n_iterations = 0;
+
+	set_iteration_controls(solver_handle, get_solver_type(), convergence_monitor.iterations_per_check);
+
+	while (convergence_history.back() > convergence_monitor.tolerance && n_iterations < convergence_monitor.max_iterations){
+
+		//
+		// Ifpack_Hypre::ApplyInverse starts from zero, so each chunk continues from x by solving for the correction
+		//
+		correction = 0.0;
+		apply_inverse(residual.trilinos_vector(),correction.trilinos_vector());
+		x += correction;
+		n_iterations += statistics.n_iterations;
+
+		convergence_history.push_back(system_matrix->residual(residual,x,b)*scaling);
+
+		if (convergence_history.back() <= convergence_monitor.tolerance)
+			break;
+
+		if (convergence_monitor.callback(n_iterations, convergence_history) == stop_iteration){
+			monitor_stopped_solve = true;
+			break;
+		}
+	}
+
+	reapply_solver_parameters(solver_handle);
+
+	statistics.n_solves = n_solves + 1;
+	statistics.n_iterations = n_iterations;
+	statistics.final_residual = convergence_history.back();
+
+}
+
+void ifpackHypreSolverBase::set_iteration_controls(HYPRE_Solver solver, const Hypre_Solver solver_type, const unsigned int n_iterations){
+	//
+	// a zero tolerance disables hypre's stopping test, so exactly n_iterations iterations are run
+	//
+	switch(solver_type)
+	{
+	case Hypre_Solver::BoomerAMG:
+		HYPRE_BoomerAMGSetMaxIter(solver, n_iterations);
+		HYPRE_BoomerAMGSetTol(solver, 0.0);
+		HYPRE_BoomerAMGSetPrintLevel(solver, 0);
+		break;
+	case Hypre_Solver::PCG:
+		HYPRE_ParCSRPCGSetMaxIter(solver, n_iterations);
+		HYPRE_ParCSRPCGSetTol(solver, 0.0);
+		HYPRE_ParCSRPCGSetPrintLevel(solver, 0);
+		break;
+	case Hypre_Solver::GMRES:
+		HYPRE_ParCSRGMRESSetMaxIter(solver, n_iterations);
+		HYPRE_ParCSRGMRESSetTol(solver, 0.0);
+		HYPRE_ParCSRGMRESSetPrintLevel(solver, 0);
+		break;
+	case Hypre_Solver::FlexGMRES:
+		HYPRE_ParCSRFlexGMRESSetMaxIter(solver, n_iterations);
+		HYPRE_ParCSRFlexGMRESSetTol(solver, 0.0);
+		HYPRE_ParCSRFlexGMRESSetPrintLevel(solver, 0);
+		break;
+	case Hypre_Solver::LGMRES:
+		HYPRE_ParCSRLGMRESSetMaxIter(solver, n_iterations);
+		HYPRE_ParCSRLGMRESSetTol(solver, 0.0);
+		HYPRE_ParCSRLGMRESSetPrintLevel(solver, 0);
+		break;
+	case Hypre_Solver::BiCGSTAB:
+		HYPRE_ParCSRBiCGSTABSetMaxIter(solver, n_iterations);
+		HYPRE_ParCSRBiCGSTABSetTol(solver, 0.0);
+		HYPRE_ParCSRBiCGSTABSetPrintLevel(solver, 0);
+		break;
+	default:
+		AssertThrow(false, ExcMessage("The convergence monitor does not support this hypre solver."));
+	}
+
+}
+
+ifpackHypreSolverBase::ConvergenceMonitor::callback_type ifpackHypreSolverBase::ConvergenceMonitor::stop_on_stagnation(const unsigned int window,const double required_reduction){
+
+	return [window,required_reduction](const unsigned int, const std::vector<double> & history){
+		if (history.size() <= window)
+			return continue_iteration;
+		return (history.back() > required_reduction*history[history.size()-1-window]) ? stop_iteration : continue_iteration;
+	};
+
+}
+
+void ifpackHypreSolverBase::set_convergence_monitor(const ConvergenceMonitor & monitor){
+
+	AssertThrow(monitor.iterations_per_check > 0, ExcMessage("The convergence monitor needs at least one iteration per check."));
+
+	convergence_monitor = monitor;
+
+}
+
+const std::vector<double> & ifpackHypreSolverBase::get_convergence_history() const{
+
+	return convergence_history;
+
+}
+
+bool ifpackHypreSolverBase::stopped_by_monitor() const{
+
+	return monitor_stopped_solve;
+
+}
+
+void ifpackHypreSolverBase::apply_inverse(const Epetra_MultiVector & B,Epetra_MultiVector & X){
+
+	Timer solve_timer;
+	const int ierr = hypre_interface->ApplyInverse(B,X);
+	solve_timer.stop();
+	AssertThrow(ierr == 0, ExcMessage("Ifpack_Hypre::ApplyInverse returned error code " + std::to_string(ierr)));
+
+	statistics.solve_time += solve_timer.wall_time();
+	statistics.n_solves += B.NumVectors();
+
+	update_iteration_statistics(solver_handle, get_solver_type());
+	update_memory_statistics();
+
+}
+
+bool ifpackHypreSolverBase::solve_with_frozen_setup(LinearAlgebraTrilinos::MPI::Vector & x,const LinearAlgebraTrilinos::MPI::Vector &b){
+
+	LinearAlgebraTrilinos::MPI::Vector residual(b);
+	LinearAlgebraTrilinos::MPI::Vector correction(b);
+
+	const double b_norm = b.l2_norm();
+	const double r0_norm = system_matrix->residual(residual,x,b);
+
+	if (r0_norm <= reuse_parameters.correction_tolerance*b_norm)
+		return true;
+
+	for (unsigned int step=1; step<=reuse_parameters.max_correction_steps; ++step){
+
+		correction = 0.0;
+		apply_inverse(residual.trilinos_vector(),correction.trilinos_vector());
+		x += correction;
+
+		const double r_norm = system_matrix->residual(residual,x,b);
+
+		if (r_norm <= reuse_parameters.correction_tolerance*b_norm)
+			return true;
+
+		const double convergence_factor = std::pow(r_norm/r0_norm, 1.0/step);
+
+		if (convergence_factor > reuse_parameters.max_convergence_factor)
+			return false;
+	}
+
+	return false;
+
+}
+
+void ifpackHypreSolverBase::solve(Epetra_MultiVector & X,const Epetra_MultiVector &B){
+
+	assert_no_pending_async_solve();
+	AssertThrow(is_initialized(), ExcMessage("initialize must be called before solve(X,B)."));
+	AssertThrow(X.NumVectors()==B.NumVectors(), ExcDimensionMismatch(X.NumVectors(),B.NumVectors()));
+
+	if (setup_is_stale)
+		setup(*system_matrix);
+
+	std::vector<double> x_norms(X.NumVectors());
+	X.NormInf(x_norms.data());
+
+	if (*std::max_element(x_norms.begin(), x_norms.end()) == 0.0){
+		apply_inverse(B,X);
+		return;
+	}
+	//
+	// as in solve(x,b), the initial guesses enter through the residuals since Ifpack_Hypre::ApplyInverse zeroes X
+	//
+	Epetra_MultiVector residual(B);
+	Epetra_MultiVector correction(X.Map(), X.NumVectors(), true);
+
+	system_matrix->trilinos_matrix().Apply(X, residual);
+	residual.Update(1.0, B, -1.0);
+
+	apply_inverse(residual,correction);
+	X.Update(1.0, correction, 1.0);
+
+}
+
+void ifpackHypreSolverBase::solve(std::vector<LinearAlgebraTrilinos::MPI::Vector> & x,const std::vector<LinearAlgebraTrilinos::MPI::Vector> &b){
+
+	AssertThrow(x.size()==b.size(), ExcDimensionMismatch(x.size(),b.size()));
+
+	for (unsigned int i=0;i<b.size();++i)
+		solve(x[i],b[i]);
+
+}
+
+void ifpackHypreSolverBase::solve(LinearAlgebraTrilinos::MPI::SparseMatrix & A,LinearAlgebraTrilinos::MPI::Vector & x,LinearAlgebraTrilinos::MPI::Vector &b){
+
+	initialize(A);
+
+	solve(x,b);
+
+}
+
+std::future<LinearAlgebraTrilinos::MPI::Vector> ifpackHypreSolverBase::solve_async(const std::shared_ptr<const LinearAlgebraTrilinos::MPI::SparseMatrix> & A,const LinearAlgebraTrilinos::MPI::Vector & b,const LinearAlgebraTrilinos::MPI::Vector & x){
+
+	AssertThrow(A != nullptr, ExcMessage("solve_async needs a matrix."));
+	AssertThrow(!async_solve_running.exchange(true), ExcMessage("solve_async was called before the future of the previous asynchronous solve was read or destroyed."));
+
+	//
+	// no thread may use the solver until the task has started, in particular not one that ran an earlier deferred task
+	//
+	async_solve_thread = std::thread::id();
+
+	const std::shared_ptr<async_solve_guard> guard = std::make_shared<async_solve_guard>(async_solve_running);
+
+	int thread_level;
+	MPI_Query_thread(&thread_level);
+
+	const std::launch policy = (thread_level >= MPI_THREAD_MULTIPLE) ? std::launch::async : std::launch::deferred;
+
+	return std::async(policy, [this, A, b, x, guard]() mutable { return run_async_solve(A, b, x); });
+
+}
+
+LinearAlgebraTrilinos::MPI::Vector ifpackHypreSolverBase::run_async_solve(const std::shared_ptr<const LinearAlgebraTrilinos::MPI::SparseMatrix> A,const LinearAlgebraTrilinos::MPI::Vector b,LinearAlgebraTrilinos::MPI::Vector x){
+
+	async_solve_thread = std::this_thread::get_id();
+
+	const unsigned int n_setups_before = n_full_setups;
+	initialize(*A);
+	//
+	// a frozen setup still refers to the matrix of the last full setup, so that one is kept alive as well
+	//
+	if (n_full_setups != n_setups_before)
+		async_setup_matrix = A;
+	async_matrix = A;
+	solve(x,b);
+
+	return x;
+
+}
+
+ifpackHypreSolverBase::~ifpackHypreSolverBase(){
+
+	BoomerAMGParameters::release_grid_relax_points(amg_handle);
+
+}
+
+void ifpackHypreSolverBase::clear(){
+
+	assert_no_pending_async_solve();
+
+	BoomerAMGParameters::release_grid_relax_points(amg_handle);
+
+	hypre_interface.reset();
+	async_matrix.reset();
+	async_setup_matrix.reset();
+	system_matrix = nullptr;
+	setup_is_stale = false;
+	solver_handle = nullptr;
+	preconditioner_handle = nullptr;
+	amg_handle = nullptr;
+
+}
+
+void ifpackHypreSolverBase::assert_no_pending_async_solve() const{
+
+	AssertThrow(!async_solve_running || std::this_thread::get_id() == async_solve_thread.load(),
+			ExcMessage("The solver may not be used until the future returned by solve_async has been read or destroyed."));
+
+}
+
+bool ifpackHypreSolverBase::is_initialized() const{
+
+	return (hypre_interface != nullptr) && hypre_interface->IsComputed();
+
+}
+
+void ifpackHypreSolverBase::update_iteration_statistics(HYPRE_Solver solver, const Hypre_Solver solver_type){
+
+	if (solver == nullptr)
+		return;
+
+	HYPRE_Int n_iterations = 0;
+	HYPRE_Real final_residual = 0.0;
+
+	switch(solver_type)
+	{
+	case Hypre_Solver::BoomerAMG:
+		HYPRE_BoomerAMGGetNumIterations(solver, &n_iterations);
+		HYPRE_BoomerAMGGetFinalRelativeResidualNorm(solver, &final_residual);
+		break;
+	case Hypre_Solver::PCG:
+		HYPRE_ParCSRPCGGetNumIterations(solver, &n_iterations);
+		HYPRE_ParCSRPCGGetFinalRelativeResidualNorm(solver, &final_residual);
+		break;
+	case Hypre_Solver::GMRES:
+		HYPRE_ParCSRGMRESGetNumIterations(solver, &n_iterations);
+		HYPRE_ParCSRGMRESGetFinalRelativeResidualNorm(solver, &final_residual);
+		break;
+	case Hypre_Solver::FlexGMRES:
+		HYPRE_ParCSRFlexGMRESGetNumIterations(solver, &n_iterations);
+		HYPRE_ParCSRFlexGMRESGetFinalRelativeResidualNorm(solver, &final_residual);
+		break;
+	case Hypre_Solver::LGMRES:
+		HYPRE_ParCSRLGMRESGetNumIterations(solver, &n_iterations);
+		HYPRE_ParCSRLGMRESGetFinalRelativeResidualNorm(solver, &final_residual);
+		break;
+	case Hypre_Solver::BiCGSTAB:
+		HYPRE_ParCSRBiCGSTABGetNumIterations(solver, &n_iterations);
+		HYPRE_ParCSRBiCGSTABGetFinalRelativeResidualNorm(solver, &final_residual);
+		break;
+	default:
+		return;
+	}
+
+	statistics.n_iterations = n_iterations;
+	statistics.total_iterations += n_iterations;
+	statistics.final_residual = final_residual;
+
+}
+
+void ifpackHypreSolverBase::update_hierarchy_statistics(HYPRE_Solver amg_solver){
+
+#ifdef BOOMERAMG_SOLVER_HYPRE_INTERNALS
+	if (amg_solver == nullptr)
+		return;
+
+	hypre_ParAMGData * amg_data = (hypre_ParAMGData *) amg_solver;
+
+	const HYPRE_Int n_levels = hypre_ParAMGDataNumLevels(amg_data);
+	hypre_ParCSRMatrix ** A_array = hypre_ParAMGDataAArray(amg_data);
+
+	if (n_levels == 0 || A_array == nullptr || A_array[0] == nullptr)
+		return;
+
+	double n_rows = 0.0, n_nonzeros = 0.0;
+
+	for (HYPRE_Int level=0; level<n_levels; ++level){
+		hypre_ParCSRMatrixSetDNumNonzeros(A_array[level]);
+		n_rows += hypre_ParCSRMatrixGlobalNumRows(A_array[level]);
+		n_nonzeros += hypre_ParCSRMatrixDNumNonzeros(A_array[level]);
+	}
+
+	statistics.n_levels = n_levels;
+	statistics.grid_complexity = n_rows/hypre_ParCSRMatrixGlobalNumRows(A_array[0]);
+	statistics.operator_complexity = n_nonzeros/hypre_ParCSRMatrixDNumNonzeros(A_array[0]);
+#else
+	(void) amg_solver;
+#endif
+
+}
+
+void ifpackHypreSolverBase::update_memory_statistics(){
+
+	Utilities::System::MemoryStats memory_stats;
+	Utilities::System::get_memory_stats(memory_stats);
+
+	statistics.peak_memory = std::max(statistics.peak_memory, memory_stats.VmHWM/1024.0);
+
+}
+
+ifpackHypreSolverBase::Statistics ifpackHypreSolverBase::get_statistics() const{
+
+	assert_no_pending_async_solve();
+
+	Statistics reduced_statistics = statistics;
+
+	reduced_statistics.parameter_time = Utilities::MPI::max(statistics.parameter_time, statistics_communicator);
+	reduced_statistics.conversion_time = Utilities::MPI::max(statistics.conversion_time, statistics_communicator);
+	reduced_statistics.setup_time = Utilities::MPI::max(statistics.setup_time, statistics_communicator);
+	reduced_statistics.solve_time = Utilities::MPI::max(statistics.solve_time, statistics_communicator);
+	reduced_statistics.peak_memory = Utilities::MPI::max(statistics.peak_memory, statistics_communicator);
+	reduced_statistics.total_peak_memory = Utilities::MPI::sum(statistics.peak_memory, statistics_communicator);
+	reduced_statistics.n_mpi_processes = Utilities::MPI::n_mpi_processes(statistics_communicator);
+
+	return reduced_statistics;
+
+}
+
+void ifpackHypreSolverBase::reset_statistics(){
+
+	statistics = Statistics();
+
+}
+
+void ifpackHypreSolverBase::Statistics::write_json(std::ostream & out) const{
+
+	out << "{\n"
+		<< "  \"n_mpi_processes\": " << n_mpi_processes << ",\n"
+		<< "  \"parameter_time\": " << parameter_time << ",\n"
+		<< "  \"conversion_time\": " << conversion_time << ",\n"
+		<< "  \"setup_time\": " << setup_time << ",\n"
+		<< "  \"solve_time\": " << solve_time << ",\n"
+		<< "  \"n_setups\": " << n_setups << ",\n"
+		<< "  \"n_solves\": " << n_solves << ",\n"
+		<< "  \"n_iterations\": " << n_iterations << ",\n"
+		<< "  \"total_iterations\": " << total_iterations << ",\n"
+		<< "  \"final_residual\": " << final_residual << ",\n"
+		<< "  \"n_levels\": " << n_levels << ",\n"
+		<< "  \"grid_complexity\": " << grid_complexity << ",\n"
+		<< "  \"operator_complexity\": " << operator_complexity << ",\n"
+		<< "  \"peak_memory_MB\": " << peak_memory << ",\n"
+		<< "  \"total_peak_memory_MB\": " << total_peak_memory << "\n"
+		<< "}" << std::endl;
+
+}
+
+
+void SolverBoomerAMG::set_parameters(Ifpack_Hypre & hypre_interface){
+
+	cache_hit = false;
+	if (!parameter_cache_file.empty()){
+		const BoomerAMGParameterCache cache(parameter_cache_file, system_matrix->get_mpi_communicator(), parameter_cache_max_distance);
+		cache_hit = cache.lookup(*system_matrix, SolverParameters);
+	}
 
 	Teuchos :: ParameterList parameter_list;
 	parameter_list.set("Solver",Hypre_Solver::BoomerAMG);
@@ -194,19 +1155,193 @@ void SolverBoomerAMG::solve(LinearAlgebraTrilinos::MPI::SparseMatrix & A,LinearA
 	hypre_interface.SetParameters(parameter_list);
 	SolverParameters.set_parameters(hypre_interface);
 
-	hypre_interface.Compute()  ;
+}
+
 
-	Epetra_FEVector & ref_soln = x.trilinos_vector();
+void SolverBoomerAMG::set_parameter_cache(const std::string & filename,const double max_distance){
 
-	hypre_interface.ApplyInverse(b.trilinos_vector(),ref_soln);
+	parameter_cache_file = filename;
+	parameter_cache_max_distance = max_distance;
 
 }
 
+bool SolverBoomerAMG::parameter_cache_hit() const{
 
-void BoomerAMG_PreconditionedSolver::solve(LinearAlgebraTrilinos::MPI::SparseMatrix & A,LinearAlgebraTrilinos::MPI::Vector & x,LinearAlgebraTrilinos::MPI::Vector &b){
+	return cache_hit;
 
-	Epetra_CrsMatrix * sys_matrix_pt=const_cast<Epetra_CrsMatrix *>(&A.trilinos_matrix());
-	Ifpack_Hypre hypre_interface( sys_matrix_pt );
+}
+
+SolverBoomerAMG::~SolverBoomerAMG(){
+
+	clear_native();
+
+}
+
+void SolverBoomerAMG::initialize(const HypreParMatrix & A){
+
+	assert_no_pending_async_solve();
+
+	clear();
+
+	native_matrix = &A;
+
+	const IndexSet & owned_rows = A.locally_owned_range_indices();
+	const HYPRE_Int n_local_rows = owned_rows.n_elements();
+	const HYPRE_Int ilower = (n_local_rows > 0) ? owned_rows.nth_index_in_set(0) : 0;
+	const HYPRE_Int iupper = ilower + n_local_rows - 1;
+
+	native_indices.resize(n_local_rows);
+	for (HYPRE_Int i=0;i<n_local_rows;++i)
+		native_indices[i] = ilower + i;
+
+	HYPRE_IJVectorCreate(A.get_mpi_communicator(), ilower, iupper, &native_x);
+	HYPRE_IJVectorSetObjectType(native_x, HYPRE_PARCSR);
+	HYPRE_IJVectorInitialize(native_x);
+	HYPRE_IJVectorAssemble(native_x);
+
+	HYPRE_IJVectorCreate(A.get_mpi_communicator(), ilower, iupper, &native_b);
+	HYPRE_IJVectorSetObjectType(native_b, HYPRE_PARCSR);
+	HYPRE_IJVectorInitialize(native_b);
+	HYPRE_IJVectorAssemble(native_b);
+
+	HYPRE_ParVector par_x, par_b;
+	HYPRE_IJVectorGetObject(native_x, (void **) &par_x);
+	HYPRE_IJVectorGetObject(native_b, (void **) &par_b);
+
+	statistics_communicator = A.get_mpi_communicator();
+
+	Timer parameter_timer;
+	HYPRE_BoomerAMGCreate(&native_solver);
+	SolverParameters.set_parameters(native_solver);
+	parameter_timer.stop();
+	statistics.parameter_time += parameter_timer.wall_time();
+
+	Timer setup_timer;
+	const HYPRE_Int ierr = HYPRE_BoomerAMGSetup(native_solver, A.par_csr_matrix(), par_b, par_x);
+	setup_timer.stop();
+	AssertThrow(ierr == 0, ExcMessage("HYPRE_BoomerAMGSetup returned error code " + std::to_string(ierr)));
+	statistics.setup_time += setup_timer.wall_time();
+
+	++statistics.n_setups;
+
+	update_hierarchy_statistics(native_solver);
+	update_memory_statistics();
+
+}
+
+void SolverBoomerAMG::solve(LinearAlgebraTrilinos::MPI::Vector & x,const LinearAlgebraTrilinos::MPI::Vector &b){
+
+	if (native_solver == nullptr){
+		ifpackHypreSolverBase::solve(x,b);
+		return;
+	}
+
+	assert_no_pending_async_solve();
+	AssertThrow(!convergence_monitor.callback, ExcMessage("The convergence monitor is not supported for a HypreParMatrix setup."));
+
+	AssertThrow(x.local_size()==native_indices.size(), ExcDimensionMismatch(x.local_size(),native_indices.size()));
+	AssertThrow(b.local_size()==native_indices.size(), ExcDimensionMismatch(b.local_size(),native_indices.size()));
+
+	solve_native(x.begin(), b.begin());
+
+}
+
+void SolverBoomerAMG::solve(Epetra_MultiVector & X,const Epetra_MultiVector &B){
+
+	if (native_solver == nullptr){
+		ifpackHypreSolverBase::solve(X,B);
+		return;
+	}
+
+	assert_no_pending_async_solve();
+	AssertThrow(!convergence_monitor.callback, ExcMessage("The convergence monitor is not supported for a HypreParMatrix setup."));
+
+	AssertThrow(X.NumVectors()==B.NumVectors(), ExcDimensionMismatch(X.NumVectors(),B.NumVectors()));
+	AssertThrow((unsigned int)X.MyLength()==native_indices.size(), ExcDimensionMismatch(X.MyLength(),native_indices.size()));
+	AssertThrow((unsigned int)B.MyLength()==native_indices.size(), ExcDimensionMismatch(B.MyLength(),native_indices.size()));
+
+	for (int i=0;i<B.NumVectors();++i)
+		solve_native(X[i], B[i]);
+
+}
+
+void SolverBoomerAMG::solve_native(double * x_values,const double * b_values){
+
+	const HYPRE_Int n_local_rows = native_indices.size();
+
+	HYPRE_IJVectorInitialize(native_b);
+	HYPRE_IJVectorSetValues(native_b, n_local_rows, native_indices.data(), b_values);
+	HYPRE_IJVectorAssemble(native_b);
+
+	HYPRE_IJVectorInitialize(native_x);
+	HYPRE_IJVectorSetValues(native_x, n_local_rows, native_indices.data(), x_values);
+	HYPRE_IJVectorAssemble(native_x);
+
+	HYPRE_ParVector par_x, par_b;
+	HYPRE_IJVectorGetObject(native_x, (void **) &par_x);
+	HYPRE_IJVectorGetObject(native_b, (void **) &par_b);
+
+	Timer solve_timer;
+	const HYPRE_Int ierr = HYPRE_BoomerAMGSolve(native_solver, native_matrix->par_csr_matrix(), par_b, par_x);
+	solve_timer.stop();
+	//
+	// not reaching the tolerance is reported through the iteration statistics, as on the Ifpack_Hypre path
+	//
+	HYPRE_ClearError(HYPRE_ERROR_CONV);
+	AssertThrow((ierr & ~HYPRE_ERROR_CONV) == 0, ExcMessage("HYPRE_BoomerAMGSolve returned error code " + std::to_string(ierr)));
+	statistics.solve_time += solve_timer.wall_time();
+	++statistics.n_solves;
+
+	HYPRE_IJVectorGetValues(native_x, n_local_rows, native_indices.data(), x_values);
+
+	update_iteration_statistics(native_solver, Hypre_Solver::BoomerAMG);
+	update_memory_statistics();
+
+}
+
+void SolverBoomerAMG::clear(){
+
+	assert_no_pending_async_solve();
+
+	clear_native();
+	ifpackHypreSolverBase::clear();
+
+}
+
+void SolverBoomerAMG::clear_native(){
+
+	if (native_solver != nullptr){
+		BoomerAMGParameters::release_grid_relax_points(native_solver);
+		HYPRE_BoomerAMGDestroy(native_solver);
+	}
+	if (native_x != nullptr)
+		HYPRE_IJVectorDestroy(native_x);
+	if (native_b != nullptr)
+		HYPRE_IJVectorDestroy(native_b);
+
+	native_solver = nullptr;
+	native_x = nullptr;
+	native_b = nullptr;
+	native_matrix = nullptr;
+	native_indices.clear();
+
+}
+
+
+Hypre_Solver SolverBoomerAMG::get_solver_type() const{
+
+	return Hypre_Solver::BoomerAMG;
+
+}
+
+void SolverBoomerAMG::reapply_solver_parameters(HYPRE_Solver solver){
+
+	SolverParameters.set_parameters(solver);
+
+}
+
+
+void BoomerAMG_PreconditionedSolver::set_parameters(Ifpack_Hypre & hypre_interface){
 
 	Teuchos :: ParameterList parameter_list;
 	parameter_list.set("Preconditioner",Hypre_Solver::BoomerAMG);
@@ -217,22 +1352,98 @@ void BoomerAMG_PreconditionedSolver::solve(LinearAlgebraTrilinos::MPI::SparseMat
 	hypre_interface.SetParameters(parameter_list);
 	BoomerAMG_precond_parameters.set_parameters(hypre_interface);
 	solver_parameters.set_parameters(hypre_interface);
+	//
+	// registered after the parameter object so that these settings take precedence
+	//
+	if (additional_data.reduced_memory_hierarchy){
+		hypre_interface.SetParameter(Hypre_Chooser::Preconditioner, &HYPRE_BoomerAMGSetTruncFactor, additional_data.interpolation_truncation);
+		hypre_interface.SetParameter(Hypre_Chooser::Preconditioner, &HYPRE_BoomerAMGSetFilterThresholdR, additional_data.restriction_filter);
+	}
+
+}
+
+Hypre_Solver BoomerAMG_PreconditionedSolver::get_solver_type() const{
+
+	return solver_parameters.solver_selection;
+
+}
+
+bool BoomerAMG_PreconditionedSolver::has_amg_preconditioner() const{
+
+	return true;
+
+}
 
+void BoomerAMG_PreconditionedSolver::reapply_solver_parameters(HYPRE_Solver solver){
 
-	hypre_interface.Initialize();
+	solver_parameters.set_parameters(solver);
 
-	hypre_interface.Compute()  ;
+}
 
-	Epetra_FEVector & ref_soln = x.trilinos_vector();
+PreconditionBoomerAMG::~PreconditionBoomerAMG(){
 
-	hypre_interface.ApplyInverse(b.trilinos_vector(),ref_soln);
+	release_grid_relax_points();
 
 }
 
-void ifpack_solver::solve(LinearAlgebraTrilinos::MPI::SparseMatrix & A, LinearAlgebraTrilinos::MPI::Vector & x, LinearAlgebraTrilinos::MPI::Vector &b){
+void PreconditionBoomerAMG::release_grid_relax_points(){
+	//
+	// only detach the relaxation points when no copy of this preconditioner shares the hypre solver
+	//
+	if (!preconditioner.is_null() && preconditioner.strong_count() == 1)
+		BoomerAMGParameters::release_grid_relax_points(amg_handle);
+
+	amg_handle = nullptr;
+
+}
+
+void PreconditionBoomerAMG::clear(){
+
+	release_grid_relax_points();
+	PreconditionBase::clear();
+
+}
+
+void PreconditionBoomerAMG::initialize(const LinearAlgebraTrilinos::MPI::SparseMatrix & A){
+
+	clear();
 
 	Epetra_CrsMatrix * sys_matrix_pt=const_cast<Epetra_CrsMatrix *>(&A.trilinos_matrix());
-	Ifpack_Hypre hypre_interface( sys_matrix_pt );
+	Teuchos::RCP<Ifpack_Hypre> hypre_interface = Teuchos::rcp(new Ifpack_Hypre( sys_matrix_pt ));
+
+	Teuchos :: ParameterList parameter_list;
+	parameter_list.set("Preconditioner",Hypre_Solver::BoomerAMG);
+	parameter_list.set("SolveOrPrecondition",Hypre_Chooser::Preconditioner);
+	parameter_list.set("SetPreconditioner",false);
+
+	hypre_interface->SetParameters(parameter_list);
+	BoomerAMG_precond_parameters.set_parameters(*hypre_interface);
+	hypre_interface->SetParameter(Hypre_Chooser::Preconditioner, &capture_solver_handle, reinterpret_cast<int *>(&amg_handle));
+
+	int ierr = hypre_interface->Initialize();
+	AssertThrow(ierr == 0, ExcMessage("Ifpack_Hypre::Initialize returned error code " + std::to_string(ierr)));
+
+	ierr = hypre_interface->Compute();
+	AssertThrow(ierr == 0, ExcMessage("Ifpack_Hypre::Compute returned error code " + std::to_string(ierr)));
+
+	AssertThrow(amg_handle != nullptr, ExcMessage("Ifpack_Hypre did not apply the set function capturing its hypre handle."));
+
+	preconditioner = hypre_interface;
+
+}
+
+void PreconditionBoomerAMG::vmult(LinearAlgebraTrilinos::MPI::Vector & dst,const LinearAlgebraTrilinos::MPI::Vector &src) const{
+
+	AssertThrow(!preconditioner.is_null(), ExcMessage("initialize must be called before vmult."));
+
+	dst = 0.0;
+
+	const int ierr = preconditioner->ApplyInverse(src.trilinos_vector(),dst.trilinos_vector());
+	AssertThrow(ierr == 0, ExcMessage("Ifpack_Hypre::ApplyInverse returned error code " + std::to_string(ierr)));
+
+}
+
+void ifpack_solver::set_parameters(Ifpack_Hypre & hypre_interface){
 
 	Teuchos :: ParameterList parameter_list;
 	parameter_list.set("Solver",solver_parameters.solver_selection);
@@ -242,13 +1453,17 @@ void ifpack_solver::solve(LinearAlgebraTrilinos::MPI::SparseMatrix & A, LinearAl
 	hypre_interface.SetParameters(parameter_list);
 	solver_parameters.set_parameters(hypre_interface);
 
-	hypre_interface.Initialize();
+}
 
-	hypre_interface.Compute()  ;
+Hypre_Solver ifpack_solver::get_solver_type() const{
+
+	return solver_parameters.solver_selection;
+
+}
 
-	Epetra_FEVector & ref_soln = x.trilinos_vector();
+void ifpack_solver::reapply_solver_parameters(HYPRE_Solver solver){
 
-	hypre_interface.ApplyInverse(b.trilinos_vector(),ref_soln);
+	solver_parameters.set_parameters(solver);
 
 }
 
@@ -1,18 +1,64 @@
+#ifndef BoomerAMG_solver_h
+#define BoomerAMG_solver_h
+
 #include<Ifpack_Hypre.h>
 #include<Epetra_MultiVector.h>
 
 #include <deal.II/lac/generic_linear_algebra.h>
 #include <deal.II/lac/trilinos_vector.h>
 #include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/trilinos_precondition.h>
 #include <deal.II/base/config.h>
 #include <deal.II/base/exceptions.h>
 
 #include "boost/variant.hpp"
 
+#include "hypre_par_matrix.h"
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <ostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
 DEAL_II_NAMESPACE_OPEN
 
 namespace TrilinosWrappers {
 
+/**
+ * Compile time map from the argument types of a hypre set function, following the HYPRE_Solver argument, to the type used to
+ * store the parameter value. Only the set function prototypes supported by ifpackHypreSolverPrecondParameters are
+ * specialized, so using any other prototype with ifpackHypreSolverPrecondParameters::make_parameter_data fails to compile.
+ */
+template <typename... Args>
+struct hypre_parameter_type;
+
+template <>
+struct hypre_parameter_type<int>{ typedef int type; };
+
+template <>
+struct hypre_parameter_type<double>{ typedef double type; };
+
+template <>
+struct hypre_parameter_type<double,int>{ typedef std::pair<double,int> type; };
+
+template <>
+struct hypre_parameter_type<int,int>{ typedef std::pair<int,int> type; };
+
+template <>
+struct hypre_parameter_type<int*>{ typedef int* type; };
+
+template <>
+struct hypre_parameter_type<double*>{ typedef double* type; };
+
+template <>
+struct hypre_parameter_type<int**>{ typedef int** type; };
+
 /**
  * This class is meatn to handle parameters that are used by hypre solvers and preconditioners. It stores parameter values and also interfaces
  * with an ifpack_Hypre object to actually set the parameter values.
@@ -57,6 +103,18 @@ public:
 		 * set functions predifined in the hypre library is not sufficient. If this is used, hypre_function should be equal to nullptr
 		 */
 		std::function<void(const Hypre_Chooser, const parameter_data &, Ifpack_Hypre &)> set_function=nullptr;
+		/**
+		 * native_set_function is the counterpart of set_function used when the parameters are applied directly to a hypre
+		 * solver handle rather than through an Ifpack_Hypre object, see set_parameters(HYPRE_Solver). It may be left as a
+		 * nullptr if the parameter is only used with Ifpack_Hypre.
+		 */
+		std::function<void(const parameter_data &, HYPRE_Solver)> native_set_function=nullptr;
+		/**
+		 * typed_set_function and typed_native_set_function are set by make_parameter_data. They are instantiated for the
+		 * exact prototype of hypre_function, so applying the parameter needs neither a visitor nor a runtime type check.
+		 */
+		void (*typed_set_function)(const parameter_data &, Ifpack_Hypre &, const Hypre_Chooser)=nullptr;
+		void (*typed_native_set_function)(const parameter_data &, HYPRE_Solver)=nullptr;
 		/**
 		 * Constructor.
 		 *
@@ -71,6 +129,16 @@ public:
 		 * @param set_function is a pointer to a custom set function
 		 */
 		parameter_data(param_value_variant value, std::function<void(const Hypre_Chooser, const parameter_data &, Ifpack_Hypre &)> set_function):value(value),set_function(set_function){};
+		/**
+		 * Constructor.
+		 *
+		 * @param value is the value of the parameter
+		 * @param set_function is a pointer to a custom set function
+		 * @param native_set_function is a pointer to a custom set function acting directly on a hypre solver handle
+		 */
+		parameter_data(param_value_variant value, std::function<void(const Hypre_Chooser, const parameter_data &, Ifpack_Hypre &)> set_function,
+				std::function<void(const parameter_data &, HYPRE_Solver)> native_set_function)
+		:value(value),set_function(set_function),native_set_function(native_set_function){};
 	};
 
 	/**
@@ -81,9 +149,29 @@ public:
 
 	ifpackHypreSolverPrecondParameters(const Hypre_Chooser solver_preconditioner_selection):solver_preconditioner_selection(solver_preconditioner_selection){};
 
+	/**
+	 * Copy constructor. The flat parameter table points into the parameters map, so it is rebuilt for the copy.
+	 */
+	ifpackHypreSolverPrecondParameters(const ifpackHypreSolverPrecondParameters & other)
+	:parameters(other.parameters),solver_preconditioner_selection(other.solver_preconditioner_selection){};
+
+	/**
+	 * Create the parameter_data for a parameter set by the hypre set function @p hypre_function. The value type is checked
+	 * against the prototype of the set function at compile time, e.g.
+	 * @code
+	 * make_parameter_data(&HYPRE_BoomerAMGSetStrongThreshold, 0.25);
+	 * make_parameter_data(&HYPRE_BoomerAMGSetCycleNumSweeps, std::make_pair(1,3));
+	 * @endcode
+	 * while passing 0.25 to a set function taking an int does not compile. The returned parameter is applied through a
+	 * function instantiated for the prototype, without visiting the variants.
+	 */
+	template <typename ValueType, typename... Args>
+	static parameter_data make_parameter_data(int (*hypre_function)(HYPRE_Solver, Args...), const ValueType & value);
+
 	/**
 	 * This function can be used to change the value of a parameter in the parameters map that
-	 * already exists. Use the add_parameter function if the parameter does not already exist
+	 * already exists. Use the add_parameter function if the parameter does not already exist. The type of
+	 * @p value must be the type of the value already stored, otherwise an exception is thrown.
 	 *
 	 * @param name is the string parameter name. Note that the parameter name should already exist
 	 * in the parameters parameter map. Use the add_parameter function to add a new parameters.
@@ -116,11 +204,50 @@ public:
 	 */
 	template<typename return_type>
 	void return_parameter_value(const std::string name);
+	/**
+	 * Return the value of the parameter @p name. The parameter must exist.
+	 */
+	param_value_variant get_parameter_value(const std::string name) const;
+	/**
+	 * Return whether a parameter named @p name exists
+	 */
+	bool has_parameter(const std::string name) const;
+	/**
+	 * Write the values of all parameters to @p out, one parameter per line in the form <tt>name type value</tt>. Parameters
+	 * holding pointers are skipped since their values cannot be persisted. The output can be read back with read_parameters.
+	 */
+	void write_parameters(std::ostream & out) const;
+	/**
+	 * Read parameter values written by write_parameters and assign them with set_parameter_value. Lines naming a parameter
+	 * that does not exist in this object are ignored, so a file written for one AMG_type may be read into another.
+	 * Empty lines and lines starting with # are skipped. Returns the number of parameters assigned.
+	 */
+	unsigned int read_parameters(std::istream & in);
+	/**
+	 * Assign values given as text in the form <tt>name = value; name = value</tt>, e.g. read from a parameter file or the
+	 * command line. Each value is converted to the type of the value already stored, the two values of a pair are separated
+	 * by a space, e.g. <tt>relax_type = 3; relaxation_order = A FFC</tt>. Unlike read_parameters, an exception is thrown for
+	 * a parameter that does not exist. Returns the number of parameters assigned.
+	 */
+	unsigned int set_parameter_values(const std::string & assignments);
+	/**
+	 * Write a single parameter value in the format used by write_parameters, i.e. <tt>type value</tt>
+	 */
+	static void write_parameter_value(std::ostream & out, const param_value_variant & value);
+	/**
+	 * Read a single parameter value written by write_parameter_value
+	 */
+	static param_value_variant read_parameter_value(std::istream & in);
 	/**
 	 * This function is to be used by the solver or preconditioner class to set the parameter values. Note that all parameters contained
 	 * in the parameters map will be set.
 	 */
 	void set_parameters(Ifpack_Hypre & Ifpack_obj);
+	/**
+	 * Same as above, but the parameters are applied directly to the hypre solver handle @p solver. This is used when hypre is
+	 * called without going through Ifpack_Hypre, e.g. by SolverBoomerAMG for a HypreParMatrix.
+	 */
+	void set_parameters(HYPRE_Solver solver);
 
 protected:
 	/**
@@ -129,6 +256,81 @@ protected:
 	std::map< std::string,parameter_data> parameters;
 
 private:
+	/**
+	 * Flat table of pointers into the parameters map, in map order. set_parameters iterates over this table instead of the
+	 * map. Pointers into a std::map stay valid until the element is erased, so the table is only rebuilt after
+	 * add_parameter or remove_parameter.
+	 */
+	std::vector<const parameter_data *> parameter_table;
+
+	/**
+	 * Whether parameter_table reflects the current content of the parameters map
+	 */
+	bool parameter_table_is_current = false;
+
+	/**
+	 * Rebuild parameter_table if required
+	 */
+	void update_parameter_table();
+
+	/**
+	 * Return the name of the type of @p value used by write_parameter_value and read_parameter_value, e.g. pair_int_int.
+	 * An empty string is returned for values holding pointers, which cannot be written.
+	 */
+	static std::string parameter_type_name(const param_value_variant & value);
+
+	/**
+	 * Apply a parameter with a single value through Ifpack_Hypre
+	 */
+	template <typename FunctionType, typename ValueType>
+	static void call_set_function(Ifpack_Hypre & Ifpack_obj, const Hypre_Chooser chooser, FunctionType hypre_function, const ValueType & value){
+		Ifpack_obj.SetParameter(chooser,hypre_function,value);
+	}
+
+	/**
+	 * Apply a parameter with a pair of values through Ifpack_Hypre
+	 */
+	template <typename FunctionType, typename T1, typename T2>
+	static void call_set_function(Ifpack_Hypre & Ifpack_obj, const Hypre_Chooser chooser, FunctionType hypre_function, const std::pair<T1,T2> & value){
+		Ifpack_obj.SetParameter(chooser,hypre_function,value.first,value.second);
+	}
+
+	/**
+	 * Apply a parameter with a single value directly to a hypre solver
+	 */
+	template <typename FunctionType, typename ValueType>
+	static void call_native_set_function(HYPRE_Solver solver, FunctionType hypre_function, const ValueType & value){
+		hypre_function(solver,value);
+	}
+
+	/**
+	 * Apply a parameter with a pair of values directly to a hypre solver
+	 */
+	template <typename FunctionType, typename T1, typename T2>
+	static void call_native_set_function(HYPRE_Solver solver, FunctionType hypre_function, const std::pair<T1,T2> & value){
+		hypre_function(solver,value.first,value.second);
+	}
+
+	/**
+	 * Apply a parameter created by make_parameter_data through Ifpack_Hypre
+	 */
+	template <typename... Args>
+	static void apply_typed_parameter(const parameter_data & param_data, Ifpack_Hypre & Ifpack_obj, const Hypre_Chooser chooser){
+		typedef int (*function_type)(HYPRE_Solver, Args...);
+		typedef typename hypre_parameter_type<Args...>::type value_type;
+		call_set_function(Ifpack_obj, chooser, boost::get<function_type>(param_data.hypre_function), boost::get<value_type>(param_data.value));
+	}
+
+	/**
+	 * Apply a parameter created by make_parameter_data directly to a hypre solver
+	 */
+	template <typename... Args>
+	static void apply_typed_parameter_native(const parameter_data & param_data, HYPRE_Solver solver){
+		typedef int (*function_type)(HYPRE_Solver, Args...);
+		typedef typename hypre_parameter_type<Args...>::type value_type;
+		call_native_set_function(solver, boost::get<function_type>(param_data.hypre_function), boost::get<value_type>(param_data.value));
+	}
+
 	/**
 	 * solver_preconditioner_selection is set by the constructor and stores whether the instance is being used to handle parameters for a solver or a preconditioner
 	 */
@@ -183,6 +385,103 @@ private:
 		Ifpack_Hypre & Ifpack_obj;
 		const Hypre_Chooser solver_preconditioner_selection;
 	};
+	/**
+	 * This class is used internally to set parameter values directly on a hypre solver handle
+	 */
+	class apply_hypre_parameter_variant_visitor:
+			public boost::static_visitor<>
+	{
+	public:
+		apply_hypre_parameter_variant_visitor(HYPRE_Solver solver)
+		:solver(solver){};
+
+		void operator()( int (* hypre_set_func)(HYPRE_Solver, int) & , int & value){
+			hypre_set_func(solver,value);
+		}
+
+		void operator()( int (* hypre_set_func)(HYPRE_Solver, double) & , double & value){
+			hypre_set_func(solver,value);
+		}
+
+		void operator()( int (* hypre_set_func)(HYPRE_Solver, double, int) & , std::pair<double,int> & value){
+			hypre_set_func(solver,value.first,value.second);
+		}
+
+		void operator()( int (* hypre_set_func)(HYPRE_Solver, int, int) & , std::pair<int,int> & value){
+			hypre_set_func(solver,value.first,value.second);
+		}
+
+		void operator()( int (* hypre_set_func)(HYPRE_Solver, int*) & , int* & value){
+			hypre_set_func(solver,value);
+		}
+
+		void operator()( int (* hypre_set_func)(HYPRE_Solver, double*) & , double* & value){
+			hypre_set_func(solver,value);
+		}
+
+		void operator()( int (* hypre_set_func)(HYPRE_Solver, int**) & , int** & value){
+			hypre_set_func(solver,value);
+		}
+
+		template <typename T, typename U>
+		void operator()(T & func, U & value){
+			(void) func;
+			(void) value;
+
+			AssertThrow(false, ExcMessage("When setting a parameter, the hypre set function prototype\nshould match the type of the parameter value given"));
+		}
+
+	private:
+		HYPRE_Solver solver;
+	};
+	/**
+	 * This class is used internally to return the name of the type of a parameter value
+	 */
+	class type_name_visitor:
+			public boost::static_visitor<std::string>
+	{
+	public:
+		std::string operator()(const int &) const { return "int"; }
+		std::string operator()(const double &) const { return "double"; }
+		std::string operator()(const std::pair<double,int> &) const { return "pair_double_int"; }
+		std::string operator()(const std::pair<int,int> &) const { return "pair_int_int"; }
+		std::string operator()(const std::pair<std::string,std::string> &) const { return "pair_string_string"; }
+
+		template <typename T>
+		std::string operator()(T * const &) const { return ""; }
+	};
+	/**
+	 * This class is used internally to write a parameter value without its type name. Empty strings are written as - so
+	 * that the value can be read back with operator>>.
+	 */
+	class write_value_visitor:
+			public boost::static_visitor<>
+	{
+	public:
+		write_value_visitor(std::ostream & out)
+		:out(out){};
+
+		void operator()(const int & value) const { out << value; }
+		void operator()(const double & value) const { out << value; }
+		void operator()(const std::pair<double,int> & value) const { out << value.first << ' ' << value.second; }
+		void operator()(const std::pair<int,int> & value) const { out << value.first << ' ' << value.second; }
+
+		void operator()(const std::pair<std::string,std::string> & value) const{
+			write_string(value.first);
+			out << ' ';
+			write_string(value.second);
+		}
+
+		template <typename T>
+		void operator()(T * const &) const{
+			AssertThrow(false, ExcMessage("Parameter values holding pointers cannot be written."));
+		}
+
+	private:
+		void write_string(const std::string & str) const { out << (str.empty() ? std::string("-") : str); }
+
+		std::ostream & out;
+	};
 	/**
 	 * This class is used internally to return parameter values
 	 */
@@ -198,6 +497,21 @@ private:
 
 };
 
+
+template <typename ValueType, typename... Args>
+ifpackHypreSolverPrecondParameters::parameter_data
+ifpackHypreSolverPrecondParameters::make_parameter_data(int (*hypre_function)(HYPRE_Solver, Args...), const ValueType & value){
+
+	static_assert(std::is_same<ValueType, typename hypre_parameter_type<Args...>::type>::value,
+			"The type of the parameter value must match the arguments of the hypre set function.");
+
+	parameter_data param_data(value, hypre_function);
+	param_data.typed_set_function = &apply_typed_parameter<Args...>;
+	param_data.typed_native_set_function = &apply_typed_parameter_native<Args...>;
+
+	return param_data;
+}
+
 /**
  * Class meant to handle BoomerAMG solver or preconditioner parameters.
  * This class adds little functionality to its base class, but includes a comprehensive list of default parameters that may be of interest for BoomerAMG when used
@@ -314,15 +628,15 @@ private:
  *
  * <td align="center"> distance_R </td>
  * <td align="left">
- * The distance_R double variable sets whether Approximate Ideal Restriction
+ * The distance_R integer variable sets whether Approximate Ideal Restriction
  * (AIR) multigrid or classical multigrid is used.
  * <ul>
- * <li> 0.0: Use classical AMG, not AIR </li>
- * <li> 1.0: Use AIR, Distance-1 LAIR is used to compute R </li>
- * <li> 2.0: Use AIR, Distance-2 LAIR is used to compute R </li>
- * <li> 3.0: Use AIR, degree 0 Neumann expansion is used to compute R </li>
- * <li> 4.0: Use AIR, degree 1 Neumann expansion is used to compute R </li>
- * <li> 5.0: Use AIR, degree 2 Neumann expansion is used to compute R </li>
+ * <li> 0: Use classical AMG, not AIR </li>
+ * <li> 1: Use AIR, Distance-1 LAIR is used to compute R </li>
+ * <li> 2: Use AIR, Distance-2 LAIR is used to compute R </li>
+ * <li> 3: Use AIR, degree 0 Neumann expansion is used to compute R </li>
+ * <li> 4: Use AIR, degree 1 Neumann expansion is used to compute R </li>
+ * <li> 5: Use AIR, degree 2 Neumann expansion is used to compute R </li>
  * </ul>
  * </td></tr>
  * </table>
@@ -362,12 +676,36 @@ public:
 
 	BoomerAMGParameters(const unsigned int max_itter,const double solv_tol,const AMG_type config_selection);
 
+	/**
+	 * hypre frees the grid_relax_points array of a BoomerAMG solver when the solver is destroyed. The arrays set for the
+	 * relaxation_order parameter are owned by BoomerAMGParameters, so this function must be called for a BoomerAMG solver
+	 * handle before the solver is destroyed. It does nothing if the solver does not hold such an array, or if the arrays are
+	 * owned by hypre because the hypre release is not one the internals access was checked against.
+	 */
+	static void release_grid_relax_points(HYPRE_Solver amg_solver);
+
 private:
 	/**
 	 * This is a special set function used to simplify the specification of relaxation orders when using
 	 * AIR amg.
 	 */
 	static void set_relaxation_order(const Hypre_Chooser solver_preconditioner_selection, const parameter_data & param_data, Ifpack_Hypre & Ifpack_obj);
+	/**
+	 * Counterpart of set_relaxation_order applying the relaxation order directly to a BoomerAMG solver handle
+	 */
+	static void set_relaxation_order_native(const parameter_data & param_data, HYPRE_Solver solver);
+	/**
+	 * Return the grid_relax_points array for a relaxation order given as a pair of down and up relaxation strings. The
+	 * array is built on the first call for a relaxation order and owned by a pool shared by all instances, so repeated
+	 * setups allocate nothing. Detaching a pooled array reads hypre internals, so for hypre releases this was not checked
+	 * against a new array owned by hypre is returned by every call instead.
+	 */
+	static int** get_grid_relax_points(const std::pair<std::string,std::string> & relaxation_order);
+	/**
+	 * Set function registered in place of HYPRE_BoomerAMGSetGridRelaxPoints. It detaches a pooled array set earlier, which
+	 * hypre would otherwise free, before setting @p grid_relax_points.
+	 */
+	static int set_grid_relax_points(HYPRE_Solver solver, int** grid_relax_points);
 	/**
 	 *
 	 */
@@ -378,6 +716,16 @@ private:
  /**
   * This class adds minimal functionality to its base class. It is meant to be used to handle parameters for a hypre solver other than BoomerAMG.
   * In particular, it is used by BoomerAMG_PreconditionedSolver to handle the solver parameters.
+  *
+  * Defaults are provided for the hypre Krylov solvers PCG, GMRES, FlexGMRES, LGMRES and BiCGSTAB. The parameter names are the
+  * lower case solver name followed by the parameter, e.g. for GMRES:
+  * <ul>
+  * <li> gmres_convergence_tol: relative residual tolerance, set to @p solv_tol </li>
+  * <li> gmres_max_itter: maximum number of iterations, set to @p max_itter </li>
+  * <li> gmres_restart: restart length (Krylov space dimension), 30. Only for GMRES, FlexGMRES and LGMRES. </li>
+  * <li> gmres_print_level: hypre print level, 3 </li>
+  * </ul>
+  * LGMRES additionally has lgmres_augmentation_dim, the number of augmentation vectors kept across restarts, 2.
   */
 class ifpackSolverParameters: public ifpackHypreSolverPrecondParameters{
 public:
@@ -388,95 +736,834 @@ public:
 	ifpackSolverParameters(const unsigned int max_itter,const double solv_tol,const Hypre_Solver solver_selection=Hypre_Solver::PCG);
 
 	/**
-	 *
+	 * Set the relative residual tolerance of the selected solver
 	 */
-	Hypre_Solver solver_selection;
+	void set_tolerance(const double solv_tol);
 
-};
+	/**
+	 * Set the maximum number of iterations of the selected solver
+	 */
+	void set_max_iterations(const unsigned int max_itter);
+
+	/**
+	 * Set the restart length of the selected solver. Only GMRES, FlexGMRES and LGMRES have a restart length.
+	 */
+	void set_restart(const unsigned int restart);
+
+	/**
+	 * Set the hypre print level of the selected solver
+	 */
+	void set_print_level(const int print_level);
 
-/**
- * This class serves as an interface to ifpack for using a BoomerAMG as a solver
- *
- * @ingroup TrilinosWrappers
- * @author Joshua Hanophy, 2019
- */
-class SolverBoomerAMG{
-public:
 	/**
-	 * Constructor
 	 *
-	 * @param SolverParameters is the instance of BoomerAMGParameters container the parameter that the solver will use.
 	 */
-	SolverBoomerAMG(BoomerAMGParameters & SolverParameters):
-		SolverParameters(SolverParameters){};
+	Hypre_Solver solver_selection;
 
-    /**
-     * Solve the linear system <tt>Ax=b</tt> where <tt>A</tt> is a matrix,
-     * @p x and @p b are vectors.
-     */
-	void solve(LinearAlgebraTrilinos::MPI::SparseMatrix & A,
-			   LinearAlgebraTrilinos::MPI::Vector &x,
-			   LinearAlgebraTrilinos::MPI::Vector & b);
 private:
 	/**
-	 * SolverParameters is set by the constructor and stores a reference to the parameter object
+	 * Return the prefix of the parameter names of the selected solver, e.g. gmres_
 	 */
-	BoomerAMGParameters & SolverParameters;
+	std::string parameter_prefix() const;
 
 };
 
 /**
- * This class serves as an interface to ifpack for using a hypre solver with a BoomerAMG preconditioner
+ * Base class for the ifpack interfaces to the hypre solvers. It owns the Ifpack_Hypre object so that the hypre setup, which for
+ * BoomerAMG includes building the complete AMG hierarchy, is paid once by initialize() and then reused by every subsequent call
+ * to solve(x,b). Derived classes only need to tell the Ifpack_Hypre object which solver and preconditioner to use and apply
+ * their parameters, which is done by overriding set_parameters().
+ *
+ * The Ifpack_Hypre object keeps a pointer to the matrix given to initialize(), so the matrix must outlive the setup, i.e. it
+ * must not be destroyed before clear() or initialize() is called again.
  *
  * @ingroup TrilinosWrappers
- * @author Joshua Hanophy, 2019
  */
-class BoomerAMG_PreconditionedSolver{
+class ifpackHypreSolverBase{
 public:
 	/**
-	 * Constructor.
-	 * @param BoomerAMG_precond_parameters is the instance of BoomerAMGParameters hanlding the BoomerAMG parameters
-	 * @param solver_parameters is the instance of ifpackSolverParameters hanlding the solver parameters
+	 * Parameters controlling whether the hypre setup is reused when initialize() is called with a new matrix of the same size,
+	 * as happens in Newton or Picard loops where the matrix changes only slightly between solves.
+	 *
+	 * When reuse is enabled, the previous hypre setup is frozen instead of being recomputed. solve(x,b) then runs a defect
+	 * correction on the new matrix, <tt>x += M^{-1}(b-Ax)</tt>, where <tt>M^{-1}</tt> is the hypre solver built for the old matrix.
+	 * If the correction does not reach correction_tolerance within max_correction_steps, or the observed convergence factor
+	 * exceeds max_convergence_factor, a full setup is performed for the new matrix and the solve is completed with it.
 	 */
-    BoomerAMG_PreconditionedSolver(BoomerAMGParameters & BoomerAMG_precond_parameters, ifpackSolverParameters & solver_parameters)
-	:BoomerAMG_precond_parameters(BoomerAMG_precond_parameters),solver_parameters(solver_parameters){};
+	struct ReuseParameters{
+		/**
+		 * Constructor.
+		 */
+		ReuseParameters(const bool reuse_setup = false,
+						const unsigned int max_correction_steps = 10,
+						const double correction_tolerance = 1.e-8,
+						const double max_convergence_factor = 0.5)
+		:reuse_setup(reuse_setup),max_correction_steps(max_correction_steps),
+		 correction_tolerance(correction_tolerance),max_convergence_factor(max_convergence_factor){};
+		/**
+		 * Whether the setup is frozen and reused for new matrices of the same size
+		 */
+		bool reuse_setup;
+		/**
+		 * Maximum number of defect correction steps with a frozen setup before a full setup is triggered
+		 */
+		unsigned int max_correction_steps;
+		/**
+		 * Tolerance on the residual relative to the norm of the right hand side at which the defect correction stops
+		 */
+		double correction_tolerance;
+		/**
+		 * Largest acceptable average residual reduction per correction step. A larger factor triggers a full setup.
+		 */
+		double max_convergence_factor;
+	};
 
-    /**
-     * Solve the linear system <tt>Ax=b</tt> where <tt>A</tt> is a matrix,
-     * @p x and @p b are vectors.
-     */
-	void solve(LinearAlgebraTrilinos::MPI::SparseMatrix & A,
-			   LinearAlgebraTrilinos::MPI::Vector &x,
-			   LinearAlgebraTrilinos::MPI::Vector & b);
-private:
 	/**
-	 * BoomerAMG_precond_parameters is set by the constructor and stores a reference to the parameter object handling the BoomerAMG
-	 * parameters for the preconditioner
+	 * Action returned by the callback of a ConvergenceMonitor
 	 */
-	BoomerAMGParameters & BoomerAMG_precond_parameters;
+	enum IterationAction {
+		/**
+		 * Keep iterating
+		 */
+		continue_iteration,
+		/**
+		 * Stop the solve and return the current iterate
+		 */
+		stop_iteration
+	};
+
 	/**
-	 * solver_parameters is set by the constructor and stores a reference to the parameter object handling the solver parameters
+	 * Settings for monitoring the convergence of solve(x,b) on the calling side instead of through hypre's printing.
+	 *
+	 * When a callback is set, solve(x,b) runs the hypre solver iterations_per_check iterations at a time, with hypre's own
+	 * stopping test and printing switched off. Each run solves for the correction <tt>c</tt> from <tt>Ac = b-Ax</tt> and adds
+	 * it to <tt>x</tt>, since hypre is always started from a zero vector. After each run the relative residual
+	 * <tt>|b-Ax|/|b|</tt> is computed and appended to the convergence history, and the callback is called with the number of
+	 * iterations so far and the history. The solve ends when the residual is below tolerance, max_iterations is reached or
+	 * the callback returns stop_iteration. A driver can then check stopped_by_monitor() and switch strategy, e.g. from
+	 * BoomerAMG as a solver to BoomerAMG preconditioned GMRES.
+	 *
+	 * Krylov solvers are restarted at every check, so iterations_per_check should be a multiple of the restart length for
+	 * GMRES and larger for PCG and BiCGSTAB. Each check costs one matrix vector product.
 	 */
-	ifpackSolverParameters & solver_parameters;
-
-};
-
-
-class ifpack_solver{
-public:
+	struct ConvergenceMonitor{
+		/**
+		 * Type of the callback. The last entry of the history is the current relative residual.
+		 */
+		typedef std::function<IterationAction(const unsigned int iteration, const std::vector<double> & history)> callback_type;
 
-	ifpack_solver(ifpackSolverParameters & solver_parameters):solver_parameters(solver_parameters){};
-    /**
-     * Solve the linear system <tt>Ax=b</tt> where <tt>A</tt> is a matrix,
-     * @p x and @p b are vectors.
-     */
-	void solve(LinearAlgebraTrilinos::MPI::SparseMatrix & A,
-			   LinearAlgebraTrilinos::MPI::Vector &x,
-			   LinearAlgebraTrilinos::MPI::Vector & b);
+		/**
+		 * Constructor.
+		 */
+		ConvergenceMonitor(const callback_type & callback = callback_type(),
+						   const unsigned int max_iterations = 100,
+						   const double tolerance = 1.e-8,
+						   const unsigned int iterations_per_check = 1)
+		:callback(callback),max_iterations(max_iterations),tolerance(tolerance),iterations_per_check(iterations_per_check){
+			AssertThrow(iterations_per_check > 0, ExcMessage("The convergence monitor needs at least one iteration per check."));
+		};
+		/**
+		 * The callback. Monitoring is disabled if this is empty.
+		 */
+		callback_type callback;
+		/**
+		 * Maximum number of iterations
+		 */
+		unsigned int max_iterations;
+		/**
+		 * Relative residual at which the solve stops
+		 */
+		double tolerance;
+		/**
+		 * Number of hypre iterations between two checks
+		 */
+		unsigned int iterations_per_check;
 
-private:
-	ifpackSolverParameters & solver_parameters;
-};
+		/**
+		 * Return a callback that stops the solve if the residual was reduced by less than the factor @p required_reduction
+		 * over the last @p window checks
+		 */
+		static callback_type stop_on_stagnation(const unsigned int window = 5,
+												const double required_reduction = 0.5);
+	};
 
-} // Close namespace TrilinosWrappers
-DEAL_II_NAMESPACE_CLOSE
+	/**
+	 * Performance data collected by the solver. Times are wall times in seconds, accumulated over all setups and solves since
+	 * construction or the last call to reset_statistics(). The iteration count and final relative residual, as reported by
+	 * hypre, refer to the last solve. The hierarchy data refers to the last AMG setup and is only available when BoomerAMG is
+	 * used as the solver or the preconditioner. hypre has no public interface to the hierarchy, so it is read from hypre's
+	 * internal data for the hypre 2.x releases from 2.14 on; n_levels is zero if it is not available.
+	 */
+	struct Statistics{
+		/**
+		 * Time spent selecting the hypre solver and applying the parameters
+		 */
+		double parameter_time = 0.0;
+		/**
+		 * Time spent in Ifpack_Hypre::Initialize, which copies the Epetra matrix into a hypre IJ matrix and creates the solver
+		 */
+		double conversion_time = 0.0;
+		/**
+		 * Time spent in Ifpack_Hypre::Compute, i.e. the hypre setup. For BoomerAMG this is the construction of the hierarchy.
+		 */
+		double setup_time = 0.0;
+		/**
+		 * Time spent in Ifpack_Hypre::ApplyInverse
+		 */
+		double solve_time = 0.0;
+		/**
+		 * Number of full setups
+		 */
+		unsigned int n_setups = 0;
+		/**
+		 * Number of right hand sides solved for
+		 */
+		unsigned int n_solves = 0;
+		/**
+		 * Number of iterations of the last solve
+		 */
+		unsigned int n_iterations = 0;
+		/**
+		 * Number of iterations summed over all solves
+		 */
+		unsigned int total_iterations = 0;
+		/**
+		 * Final relative residual norm of the last solve
+		 */
+		double final_residual = 0.0;
+		/**
+		 * Number of levels in the AMG hierarchy
+		 */
+		unsigned int n_levels = 0;
+		/**
+		 * Sum of the number of rows on all levels divided by the number of rows of the finest level
+		 */
+		double grid_complexity = 0.0;
+		/**
+		 * Sum of the number of nonzeros on all levels divided by the number of nonzeros of the finest level
+		 */
+		double operator_complexity = 0.0;
+		/**
+		 * Peak resident memory of a process in MB (VmHWM)
+		 */
+		double peak_memory = 0.0;
+		/**
+		 * Sum over all processes of the peak resident memory in MB. Only set by get_statistics().
+		 */
+		double total_peak_memory = 0.0;
+		/**
+		 * Number of MPI processes the statistics were reduced over
+		 */
+		unsigned int n_mpi_processes = 1;
+
+		/**
+		 * Write the statistics as a JSON object to @p out
+		 */
+		void write_json(std::ostream & out) const;
+	};
+
+	/**
+	 * Destructor.
+	 */
+	virtual ~ifpackHypreSolverBase();
+
+	/**
+	 * Perform the hypre setup for the matrix <tt>A</tt>. Any previous setup is released first. After this call, solve(x,b) may be
+	 * called any number of times with different right hand sides without repeating the setup.
+	 *
+	 * If reuse of the setup has been enabled with set_reuse_parameters() and a setup for a matrix of the same size exists,
+	 * the existing setup is kept and only marked as stale, see ReuseParameters.
+	 */
+	void initialize(const LinearAlgebraTrilinos::MPI::SparseMatrix & A);
+
+	/**
+	 * Set the policy used by initialize() and solve(x,b) for reusing the setup with a changed matrix
+	 */
+	void set_reuse_parameters(const ReuseParameters & parameters);
+
+	/**
+	 * Return the number of full hypre setups computed since construction
+	 */
+	unsigned int n_setups() const;
+
+    /**
+     * Solve the linear system <tt>Ax=b</tt> using the setup computed by the last call to initialize(). The values in @p x
+     * are used as the initial guess. Ifpack_Hypre always starts hypre from a zero vector, so for a nonzero @p x the
+     * correction <tt>c</tt> is solved for from <tt>Ac = b-Ax</tt> and added to @p x. The relative tolerance of the hypre
+     * solver then refers to the initial residual <tt>b-Ax</tt> instead of @p b.
+     *
+     * This function is virtual so that the batched solves below use the setup of a derived class, e.g. the native
+     * HypreParMatrix setup of SolverBoomerAMG.
+     */
+	virtual void solve(LinearAlgebraTrilinos::MPI::Vector &x,
+			   const LinearAlgebraTrilinos::MPI::Vector & b);
+
+    /**
+     * Solve the linear systems <tt>AX=B</tt> for a block of right hand sides using the setup computed by the last call to
+     * initialize(). Each column of @p X holds the initial guess on entry and the solution of the corresponding column
+     * of @p B on exit. As for solve(x,b), a nonzero initial guess is handled by solving for the correction. The hierarchy
+     * is shared by all columns; hypre cycles the columns one after the other.
+     */
+	virtual void solve(Epetra_MultiVector &X,
+			   const Epetra_MultiVector & B);
+
+    /**
+     * Same as above, but with the block of right hand sides given as a vector of deal.II vectors. @p x and @p b must
+     * have the same number of entries. Each pair of vectors is passed to solve(x,b).
+     */
+	void solve(std::vector<LinearAlgebraTrilinos::MPI::Vector> &x,
+			   const std::vector<LinearAlgebraTrilinos::MPI::Vector> & b);
+
+    /**
+     * Solve the linear system <tt>Ax=b</tt> where <tt>A</tt> is a matrix,
+     * @p x and @p b are vectors. This is a shortcut for initialize(A) followed by solve(x,b), so the setup is recomputed
+     * on every call. Use the two functions separately when solving repeatedly with the same matrix.
+     */
+	void solve(LinearAlgebraTrilinos::MPI::SparseMatrix & A,
+			   LinearAlgebraTrilinos::MPI::Vector &x,
+			   LinearAlgebraTrilinos::MPI::Vector & b);
+
+	/**
+	 * Start initialize(A) followed by solve(x,b) on a worker thread and return a future holding the solution. The calling
+	 * thread may meanwhile assemble the next system or write the previous solution, e.g.
+	 * @code
+	 * std::future<LinearAlgebraTrilinos::MPI::Vector> solution = solver.solve_async(matrix, rhs, initial_guess);
+	 * output_results(previous_solution);
+	 * previous_solution = solution.get();
+	 * @endcode
+	 * The right hand side and initial guess are copied and the matrix is shared, so all three may be modified or released
+	 * by the caller right after this call; the matrix itself must not be modified until the future is ready. As for
+	 * solve(x,b), a nonzero initial guess is taken into account through the residual. The solver keeps the matrix alive for
+	 * later calls to solve(x,b).
+	 *
+	 * The solver may not be used until get() has been called on the future or the future has been destroyed; until then
+	 * initialize, solve, clear and get_statistics throw. Destroying the future without calling get() waits for a running
+	 * solve, or drops a deferred one without running it, and releases the solver in both cases.
+	 *
+	 * The worker thread runs hypre's collective operations on the communicator of the matrix. Concurrent collectives on one
+	 * communicator are erroneous in MPI, so the calling thread must not communicate on that communicator, e.g. call
+	 * compress() on matrices or vectors sharing it, until get() has returned. Only process local work such as computing
+	 * cell contributions or writing output of this process may overlap with the solve.
+	 *
+	 * The solve only runs on a worker thread if MPI was initialized with MPI_THREAD_MULTIPLE. With a lower thread level it
+	 * is deferred and runs on the calling thread when the result is requested from the future, so the code stays correct
+	 * but nothing overlaps. Utilities::MPI::MPI_InitFinalize, which all drivers in this repository use, requests
+	 * MPI_THREAD_SERIALIZED, so in these drivers solve_async never overlaps anything. A program that wants the overlap has
+	 * to call MPI_Init_thread with MPI_THREAD_MULTIPLE itself.
+	 */
+	std::future<LinearAlgebraTrilinos::MPI::Vector> solve_async(const std::shared_ptr<const LinearAlgebraTrilinos::MPI::SparseMatrix> & A,
+																const LinearAlgebraTrilinos::MPI::Vector & b,
+																const LinearAlgebraTrilinos::MPI::Vector & x);
+
+	/**
+	 * Release the hypre setup.
+	 */
+	virtual void clear();
+
+	/**
+	 * Return whether initialize() has been called since construction or the last call to clear().
+	 */
+	bool is_initialized() const;
+
+	/**
+	 * Set the convergence monitor used by solve(x,b). Pass a default constructed ConvergenceMonitor to disable monitoring.
+	 */
+	void set_convergence_monitor(const ConvergenceMonitor & monitor);
+
+	/**
+	 * Return the relative residuals of the last monitored solve, starting with the initial residual
+	 */
+	const std::vector<double> & get_convergence_history() const;
+
+	/**
+	 * Return whether the last monitored solve was stopped by the callback
+	 */
+	bool stopped_by_monitor() const;
+
+	/**
+	 * Return the statistics reduced over all processes of the matrix' communicator: times and peak memory are the maximum
+	 * over all processes. This function is collective and must be called on all processes.
+	 */
+	Statistics get_statistics() const;
+
+	/**
+	 * Reset all statistics to zero
+	 */
+	void reset_statistics();
+
+protected:
+	/**
+	 * Select the hypre solver and preconditioner on the given Ifpack_Hypre object and apply all parameters. This is called
+	 * by initialize() before the hypre setup is computed.
+	 */
+	virtual void set_parameters(Ifpack_Hypre & hypre_interface) = 0;
+
+	/**
+	 * Return the type of the outer hypre solver
+	 */
+	virtual Hypre_Solver get_solver_type() const = 0;
+
+	/**
+	 * Return whether BoomerAMG is used as the preconditioner of the outer hypre solver
+	 */
+	virtual bool has_amg_preconditioner() const { return false; };
+
+	/**
+	 * Apply the parameters of the outer solver directly to its hypre handle @p solver. This restores the iteration limits,
+	 * tolerance and print level after a monitored solve.
+	 */
+	virtual void reapply_solver_parameters(HYPRE_Solver solver) = 0;
+
+	/**
+	 * Record the iteration count and final residual of the last solve performed with @p solver, a hypre solver of type
+	 * @p solver_type
+	 */
+	void update_iteration_statistics(HYPRE_Solver solver, const Hypre_Solver solver_type);
+
+	/**
+	 * Record the number of levels and the complexities of the BoomerAMG hierarchy held by @p amg_solver. This does nothing
+	 * for hypre releases whose internal data has not been checked, see Statistics.
+	 */
+	void update_hierarchy_statistics(HYPRE_Solver amg_solver);
+
+	/**
+	 * Record the current peak memory of this process
+	 */
+	void update_memory_statistics();
+
+	/**
+	 * Throw if a solve started by solve_async is pending and this is not the thread running it
+	 */
+	void assert_no_pending_async_solve() const;
+
+	/**
+	 * Statistics of this process
+	 */
+	Statistics statistics;
+
+	/**
+	 * The convergence monitor used by solve(x,b)
+	 */
+	ConvergenceMonitor convergence_monitor;
+
+	/**
+	 * Communicator over which the statistics are reduced
+	 */
+	MPI_Comm statistics_communicator = MPI_COMM_SELF;
+
+	/**
+	 * The Ifpack_Hypre object holding the hypre setup. This is empty until initialize() is called.
+	 */
+	std::unique_ptr<Ifpack_Hypre> hypre_interface;
+
+private:
+	/**
+	 * Compute a full hypre setup for the matrix <tt>A</tt>
+	 */
+	void setup(const LinearAlgebraTrilinos::MPI::SparseMatrix & A);
+
+	/**
+	 * Solve with the current matrix using the frozen setup as the approximate inverse of a defect correction. Returns false
+	 * if the correction stagnated and a new setup is required.
+	 */
+	bool solve_with_frozen_setup(LinearAlgebraTrilinos::MPI::Vector &x,
+								 const LinearAlgebraTrilinos::MPI::Vector & b);
+
+	/**
+	 * Solve with the current setup under control of the convergence monitor
+	 */
+	void solve_monitored(LinearAlgebraTrilinos::MPI::Vector &x,
+						 const LinearAlgebraTrilinos::MPI::Vector & b);
+
+	/**
+	 * Make the hypre solver @p solver of type @p solver_type run exactly @p n_iterations iterations without printing
+	 */
+	static void set_iteration_controls(HYPRE_Solver solver, const Hypre_Solver solver_type, const unsigned int n_iterations);
+
+	/**
+	 * The task run by solve_async
+	 */
+	LinearAlgebraTrilinos::MPI::Vector run_async_solve(const std::shared_ptr<const LinearAlgebraTrilinos::MPI::SparseMatrix> A,
+													   const LinearAlgebraTrilinos::MPI::Vector b,
+													   LinearAlgebraTrilinos::MPI::Vector x);
+
+	/**
+	 * Apply the hypre solver to the columns of @p B and record the timing and iteration statistics
+	 */
+	void apply_inverse(const Epetra_MultiVector & B,
+					   Epetra_MultiVector & X);
+
+	/**
+	 * hypre solver and preconditioner handles created by Ifpack_Hypre. Ifpack_Hypre does not give access to them, so they are
+	 * captured by a set function registered with Ifpack_Hypre::SetParameter during setup.
+	 */
+	HYPRE_Solver solver_handle = nullptr;
+	HYPRE_Solver preconditioner_handle = nullptr;
+
+	/**
+	 * Whichever of the two handles above is a BoomerAMG solver, or nullptr if BoomerAMG is not used
+	 */
+	HYPRE_Solver amg_handle = nullptr;
+
+	/**
+	 * Policy for reusing the setup
+	 */
+	ReuseParameters reuse_parameters;
+
+	/**
+	 * Matrix given to the last call to initialize()
+	 */
+	const LinearAlgebraTrilinos::MPI::SparseMatrix * system_matrix = nullptr;
+
+	/**
+	 * True if the hypre setup was computed for a different matrix than system_matrix
+	 */
+	bool setup_is_stale = false;
+
+	/**
+	 * Number of full setups computed
+	 */
+	unsigned int n_full_setups = 0;
+
+	/**
+	 * The history of the last monitored solve and whether the monitor stopped it
+	 */
+	std::vector<double> convergence_history;
+	bool monitor_stopped_solve = false;
+
+	/**
+	 * Matrices given to solve_async, kept alive while the solver refers to them: the current matrix and the matrix of the
+	 * last full setup
+	 */
+	std::shared_ptr<const LinearAlgebraTrilinos::MPI::SparseMatrix> async_matrix;
+	std::shared_ptr<const LinearAlgebraTrilinos::MPI::SparseMatrix> async_setup_matrix;
+
+	/**
+	 * True from a call to solve_async until its future has been read or destroyed. The flag is reset by a guard owned by
+	 * the task stored in the future, so it is also reset if a deferred task is dropped without being run.
+	 */
+	std::atomic<bool> async_solve_running{false};
+
+	/**
+	 * The thread running the task of the last call to solve_async, which may use the solver while async_solve_running is set
+	 */
+	std::atomic<std::thread::id> async_solve_thread{std::thread::id()};
+
+};
+
+/**
+ * This class serves as an interface to ifpack for using a BoomerAMG as a solver
+ *
+ * @ingroup TrilinosWrappers
+ * @author Joshua Hanophy, 2019
+ */
+class SolverBoomerAMG: public ifpackHypreSolverBase{
+public:
+	/**
+	 * Constructor
+	 *
+	 * @param SolverParameters is the instance of BoomerAMGParameters container the parameter that the solver will use.
+	 */
+	SolverBoomerAMG(BoomerAMGParameters & SolverParameters):
+		SolverParameters(SolverParameters){};
+
+	/**
+	 * Destructor. Frees the hypre data of the native setup.
+	 */
+	~SolverBoomerAMG();
+
+	using ifpackHypreSolverBase::initialize;
+	using ifpackHypreSolverBase::solve;
+
+	/**
+	 * Perform the BoomerAMG setup directly on the hypre ParCSR matrix held by @p A. Unlike initialize for a Trilinos matrix,
+	 * no Epetra to hypre copy of the matrix is made. The matrix must outlive the setup.
+	 */
+	void initialize(const HypreParMatrix & A);
+
+    /**
+     * Solve the linear system <tt>Ax=b</tt> with the setup computed by the last call to either initialize function. The
+     * values in @p x are used as the initial guess.
+     */
+	void solve(LinearAlgebraTrilinos::MPI::Vector &x,
+			   const LinearAlgebraTrilinos::MPI::Vector & b) override;
+
+    /**
+     * Solve for a block of right hand sides with the setup computed by the last call to either initialize function. For a
+     * HypreParMatrix setup the columns are solved one after the other with the native BoomerAMG solver.
+     */
+	void solve(Epetra_MultiVector &X,
+			   const Epetra_MultiVector & B) override;
+
+	/**
+	 * Release the hypre setup of either kind.
+	 */
+	void clear() override;
+
+	/**
+	 * Look up the parameters in the BoomerAMGParameterCache file @p filename at every setup from a Trilinos matrix. The
+	 * MatrixFingerprint of the matrix is computed and, on a hit, the cached values are read into the parameter object given
+	 * to the constructor before they are applied, replacing the values set by the caller. An entry counts as a hit within
+	 * @p max_distance. An empty @p filename disables the lookup. A HypreParMatrix setup does not use the cache.
+	 */
+	void set_parameter_cache(const std::string & filename,
+							 const double max_distance = 0.1);
+
+	/**
+	 * Return whether the last setup from a Trilinos matrix loaded its parameters from the cache
+	 */
+	bool parameter_cache_hit() const;
+
+protected:
+	/**
+	 * Select BoomerAMG as the solver and apply the parameters in SolverParameters, after looking them up in the parameter
+	 * cache if one is set
+	 */
+	void set_parameters(Ifpack_Hypre & hypre_interface) override;
+
+	/**
+	 * The solver is BoomerAMG
+	 */
+	Hypre_Solver get_solver_type() const override;
+
+	/**
+	 * Apply the parameters in SolverParameters to @p solver
+	 */
+	void reapply_solver_parameters(HYPRE_Solver solver) override;
+
+private:
+	/**
+	 * SolverParameters is set by the constructor and stores a reference to the parameter object
+	 */
+	BoomerAMGParameters & SolverParameters;
+
+	/**
+	 * Settings of the parameter cache, no lookup is made if the file name is empty
+	 */
+	std::string parameter_cache_file;
+	double parameter_cache_max_distance = 0.1;
+
+	/**
+	 * Whether the last lookup in the parameter cache was a hit
+	 */
+	bool cache_hit = false;
+
+	/**
+	 * Release the hypre data of the native setup
+	 */
+	void clear_native();
+
+	/**
+	 * Solve with the native setup for the locally owned values @p b_values of the right hand side. @p x_values holds the
+	 * locally owned values of the initial guess on entry and of the solution on exit.
+	 */
+	void solve_native(double * x_values,
+					  const double * b_values);
+
+	/**
+	 * BoomerAMG solver handle used for a HypreParMatrix. This is a nullptr unless initialize(const HypreParMatrix &) was
+	 * called.
+	 */
+	HYPRE_Solver native_solver = nullptr;
+
+	/**
+	 * The matrix given to initialize(const HypreParMatrix &)
+	 */
+	const HypreParMatrix * native_matrix = nullptr;
+
+	/**
+	 * hypre vectors for the solution and right hand side of the native solve
+	 */
+	HYPRE_IJVector native_x = nullptr;
+	HYPRE_IJVector native_b = nullptr;
+
+	/**
+	 * Global indices of the locally owned rows, used to copy values between the deal.II and hypre vectors
+	 */
+	std::vector<HYPRE_Int> native_indices;
+
+};
+
+/**
+ * This class serves as an interface to ifpack for using a hypre solver with a BoomerAMG preconditioner
+ *
+ * @ingroup TrilinosWrappers
+ * @author Joshua Hanophy, 2019
+ */
+class BoomerAMG_PreconditionedSolver: public ifpackHypreSolverBase{
+public:
+	/**
+	 * Settings of the reduced memory hierarchy mode. hypre is built for a single floating point type, so the precision of
+	 * the hierarchy is not changed. Instead, this mode lowers the operator complexity, i.e. the number of nonzeros stored
+	 * on all levels, by dropping small entries from the transfer operators before the coarse operators are formed:
+	 * classical interpolation entries smaller than interpolation_truncation times the largest entry of their row, and AIR
+	 * restriction entries below restriction_filter. Only the setting matching the AMG_type has an effect, AIR uses pointwise
+	 * interpolation. The outer Krylov iteration and its residuals are unchanged, so the solver converges to the same
+	 * tolerance, possibly in a few more iterations. The saving can be read from Statistics::operator_complexity.
+	 */
+	struct AdditionalData{
+		/**
+		 * Constructor.
+		 */
+		AdditionalData(const bool reduced_memory_hierarchy = false,
+					   const double interpolation_truncation = 0.1,
+					   const double restriction_filter = 1.e-3)
+		:reduced_memory_hierarchy(reduced_memory_hierarchy),
+		 interpolation_truncation(interpolation_truncation),restriction_filter(restriction_filter){};
+		/**
+		 * Whether the hierarchy is thinned
+		 */
+		bool reduced_memory_hierarchy;
+		/**
+		 * Relative truncation threshold for classical interpolation entries
+		 */
+		double interpolation_truncation;
+		/**
+		 * Threshold below which AIR restriction entries are dropped
+		 */
+		double restriction_filter;
+	};
+
+	/**
+	 * Constructor.
+	 * @param BoomerAMG_precond_parameters is the instance of BoomerAMGParameters hanlding the BoomerAMG parameters
+	 * @param solver_parameters is the instance of ifpackSolverParameters hanlding the solver parameters
+	 * @param additional_data selects the reduced memory hierarchy mode
+	 */
+    BoomerAMG_PreconditionedSolver(BoomerAMGParameters & BoomerAMG_precond_parameters, ifpackSolverParameters & solver_parameters,
+    		const AdditionalData & additional_data = AdditionalData())
+	:BoomerAMG_precond_parameters(BoomerAMG_precond_parameters),solver_parameters(solver_parameters),additional_data(additional_data){};
+
+protected:
+	/**
+	 * Select the solver with a BoomerAMG preconditioner and apply the parameters for both
+	 */
+	void set_parameters(Ifpack_Hypre & hypre_interface) override;
+
+	/**
+	 * The solver selected in solver_parameters
+	 */
+	Hypre_Solver get_solver_type() const override;
+
+	/**
+	 * BoomerAMG is the preconditioner
+	 */
+	bool has_amg_preconditioner() const override;
+
+	/**
+	 * Apply the parameters in solver_parameters to @p solver
+	 */
+	void reapply_solver_parameters(HYPRE_Solver solver) override;
+
+private:
+	/**
+	 * BoomerAMG_precond_parameters is set by the constructor and stores a reference to the parameter object handling the BoomerAMG
+	 * parameters for the preconditioner
+	 */
+	BoomerAMGParameters & BoomerAMG_precond_parameters;
+	/**
+	 * solver_parameters is set by the constructor and stores a reference to the parameter object handling the solver parameters
+	 */
+	ifpackSolverParameters & solver_parameters;
+	/**
+	 * additional_data is set by the constructor and stores the settings of the reduced memory hierarchy mode
+	 */
+	const AdditionalData additional_data;
+
+};
+
+
+/**
+ * This class wraps BoomerAMG as a preconditioner for use with the deal.II Krylov solvers (SolverCG, SolverGMRES, SolverFGMRES, ...),
+ * the Trilinos solvers in deal.II, and the LinearOperator framework. initialize() builds the AMG hierarchy once and keeps it alive.
+ * Every vmult then applies the BoomerAMG cycles configured in the parameter object, by default a single V-cycle,
+ * without constructing a new Ifpack_Hypre object.
+ *
+ * The parameter object should be constructed for use as a preconditioner, i.e. with BoomerAMGParameters(AMG_type).
+ *
+ * @ingroup TrilinosWrappers
+ */
+class PreconditionBoomerAMG: public PreconditionBase{
+public:
+	/**
+	 * Constructor.
+	 * @param BoomerAMG_precond_parameters is the instance of BoomerAMGParameters handling the BoomerAMG parameters
+	 */
+	PreconditionBoomerAMG(BoomerAMGParameters & BoomerAMG_precond_parameters)
+	:BoomerAMG_precond_parameters(BoomerAMG_precond_parameters){};
+
+	/**
+	 * Destructor.
+	 */
+	~PreconditionBoomerAMG();
+
+	/**
+	 * Release the AMG hierarchy
+	 */
+	void clear();
+
+	/**
+	 * Build the AMG hierarchy for the matrix <tt>A</tt>. The matrix must outlive the preconditioner or the next call to
+	 * initialize().
+	 */
+	void initialize(const LinearAlgebraTrilinos::MPI::SparseMatrix & A);
+
+	using PreconditionBase::vmult;
+
+	/**
+	 * Apply the preconditioner, <tt>dst = M^{-1} src</tt>. @p dst is zeroed first so that the AMG cycle is started from a
+	 * zero initial guess and the preconditioner is a fixed linear operator.
+	 */
+	void vmult(LinearAlgebraTrilinos::MPI::Vector &dst,
+			   const LinearAlgebraTrilinos::MPI::Vector &src) const override;
+
+private:
+	/**
+	 * BoomerAMG_precond_parameters is set by the constructor and stores a reference to the parameter object handling the BoomerAMG
+	 * parameters
+	 */
+	BoomerAMGParameters & BoomerAMG_precond_parameters;
+
+	/**
+	 * The BoomerAMG solver handle created by Ifpack_Hypre, captured during initialize()
+	 */
+	HYPRE_Solver amg_handle = nullptr;
+
+	/**
+	 * Detach the pooled relaxation points from the hypre solver before it is destroyed, see
+	 * BoomerAMGParameters::release_grid_relax_points
+	 */
+	void release_grid_relax_points();
+
+};
+
+
+class ifpack_solver: public ifpackHypreSolverBase{
+public:
+
+	ifpack_solver(ifpackSolverParameters & solver_parameters):solver_parameters(solver_parameters){};
+
+protected:
+	/**
+	 * Select the solver without a preconditioner and apply the solver parameters
+	 */
+	void set_parameters(Ifpack_Hypre & hypre_interface) override;
+
+	/**
+	 * The solver selected in solver_parameters
+	 */
+	Hypre_Solver get_solver_type() const override;
+
+	/**
+	 * Apply the parameters in solver_parameters to @p solver
+	 */
+	void reapply_solver_parameters(HYPRE_Solver solver) override;
+
+private:
+	ifpackSolverParameters & solver_parameters;
+};
+
+} // Close namespace TrilinosWrappers
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
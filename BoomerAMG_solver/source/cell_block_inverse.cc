@@ -0,0 +1,223 @@
+#include <cell_block_inverse.h>
+
+#include <deal.II/lac/full_matrix.h>
+
+#include <Epetra_CrsMatrix.h>
+
+#include <algorithm>
+#include <cmath>
+
+DEAL_II_NAMESPACE_OPEN
+
+namespace TrilinosWrappers
+{
+
+
+void CellBlockInverse::initialize(const LinearAlgebraTrilinos::MPI::SparseMatrix & A,const unsigned int block_size){
+
+	const unsigned int n_lanes = VectorizedArray<double>::n_array_elements;
+	const std::pair<types::global_dof_index,types::global_dof_index> local_range = A.local_range();
+
+	AssertThrow(block_size > 0 && (local_range.second - local_range.first) % block_size == 0,
+			ExcMessage("The locally owned rows must consist of whole blocks."));
+
+	this->block_size = block_size;
+	first_row = local_range.first;
+	n_local_blocks = (local_range.second - local_range.first)/block_size;
+
+	const unsigned int n_batches = (n_local_blocks + n_lanes - 1)/n_lanes;
+	const unsigned int batch_size = block_size*block_size;
+
+	blocks.resize(n_batches*batch_size);
+	std::fill(blocks.begin(), blocks.end(), make_vectorized_array(0.0));
+	//
+	// a single pass over the local rows, only the entries inside the diagonal block of the row are kept
+	//
+	const Epetra_CrsMatrix & matrix = A.trilinos_matrix();
+
+	for (int row=0; row<matrix.NumMyRows(); ++row){
+
+		const types::global_dof_index local_row = matrix.GRID64(row) - first_row;
+		const unsigned int block = local_row/block_size;
+		const unsigned int i = local_row%block_size;
+		const types::global_dof_index block_first = first_row + block*block_size;
+
+		VectorizedArray<double> * block_row = &blocks[(block/n_lanes)*batch_size + i*block_size];
+
+		int n_entries;
+		double * values;
+		int * indices;
+		matrix.ExtractMyRowView(row, n_entries, values, indices);
+
+		for (int k=0; k<n_entries; ++k){
+			const types::global_dof_index column = matrix.GCID64(indices[k]);
+			if (column >= block_first && column < block_first + block_size)
+				block_row[column - block_first][block%n_lanes] = values[k];
+		}
+	}
+	//
+	// unused lanes of the last batch get identity blocks to keep the elimination finite
+	//
+	for (unsigned int block=n_local_blocks; block<n_batches*n_lanes; ++block)
+		for (unsigned int i=0; i<block_size; ++i)
+			blocks[(block/n_lanes)*batch_size + i*block_size + i][block%n_lanes] = 1.0;
+
+	for (unsigned int batch=0; batch<n_batches; ++batch)
+		invert_batch(batch);
+
+}
+
+unsigned int CellBlockInverse::n_blocks() const{
+
+	return n_local_blocks;
+
+}
+
+unsigned int CellBlockInverse::get_block_size() const{
+
+	return block_size;
+
+}
+
+double CellBlockInverse::operator()(const unsigned int block,const unsigned int i,const unsigned int j) const{
+
+	const unsigned int n_lanes = VectorizedArray<double>::n_array_elements;
+
+	return blocks[(block/n_lanes)*block_size*block_size + i*block_size + j][block%n_lanes];
+
+}
+
+void CellBlockInverse::vmult(LinearAlgebraTrilinos::MPI::Vector & dst,const LinearAlgebraTrilinos::MPI::Vector & src) const{
+
+	const unsigned int n_lanes = VectorizedArray<double>::n_array_elements;
+	const unsigned int batch_size = block_size*block_size;
+
+	const double * src_values = src.begin();
+	double * dst_values = dst.begin();
+
+	for (unsigned int block=0; block<n_local_blocks; ++block){
+
+		const VectorizedArray<double> * inverse = &blocks[(block/n_lanes)*batch_size];
+		const unsigned int lane = block%n_lanes;
+
+		for (unsigned int i=0; i<block_size; ++i){
+			double sum = 0.0;
+			for (unsigned int j=0; j<block_size; ++j)
+				sum += inverse[i*block_size + j][lane]*src_values[block*block_size + j];
+			dst_values[block*block_size + i] = sum;
+		}
+	}
+
+}
+
+void CellBlockInverse::scale_rows(LinearAlgebraTrilinos::MPI::SparseMatrix & A) const{
+
+	const unsigned int n_lanes = VectorizedArray<double>::n_array_elements;
+	const unsigned int batch_size = block_size*block_size;
+
+	Epetra_CrsMatrix & matrix = const_cast<Epetra_CrsMatrix &>(A.trilinos_matrix());
+
+	AssertThrow(matrix.NumMyRows() == static_cast<int>(n_local_blocks*block_size),
+			ExcMessage("The matrix does not match the extracted blocks."));
+
+	std::vector<double *> row_values(block_size);
+	std::vector<int *> row_indices(block_size);
+	std::vector<double> scaled_values;
+	//
+	// the rows of a block are read once, combined in a buffer and written back to the same storage
+	//
+	for (unsigned int block=0; block<n_local_blocks; ++block){
+
+		const VectorizedArray<double> * inverse = &blocks[(block/n_lanes)*batch_size];
+		const unsigned int lane = block%n_lanes;
+
+		int n_entries = 0;
+		for (unsigned int i=0; i<block_size; ++i){
+
+			const int row = matrix.LRID(static_cast<long long int>(first_row + block*block_size + i));
+
+			int n_row_entries;
+			matrix.ExtractMyRowView(row, n_row_entries, row_values[i], row_indices[i]);
+
+			if (i == 0)
+				n_entries = n_row_entries;
+
+			AssertThrow(n_row_entries == n_entries
+					&& std::equal(row_indices[i], row_indices[i] + n_entries, row_indices[0]),
+					ExcMessage("The rows of a block must have the same sparsity pattern."));
+		}
+
+		scaled_values.assign(block_size*n_entries, 0.0);
+
+		for (unsigned int i=0; i<block_size; ++i)
+			for (unsigned int j=0; j<block_size; ++j){
+				const double inverse_ij = inverse[i*block_size + j][lane];
+				for (int k=0; k<n_entries; ++k)
+					scaled_values[i*n_entries + k] += inverse_ij*row_values[j][k];
+			}
+
+		for (unsigned int i=0; i<block_size; ++i)
+			std::copy(&scaled_values[i*n_entries], &scaled_values[i*n_entries] + n_entries, row_values[i]);
+	}
+
+}
+
+void CellBlockInverse::invert_batch(const unsigned int batch){
+
+	const unsigned int n_lanes = VectorizedArray<double>::n_array_elements;
+	const unsigned int n = block_size;
+
+	VectorizedArray<double> * a = &blocks[batch*n*n];
+	AlignedVector<VectorizedArray<double>> original(n*n);
+	std::copy(a, a + n*n, original.begin());
+
+	VectorizedArray<double> scale = make_vectorized_array(0.0);
+	for (unsigned int k=0; k<n*n; ++k)
+		scale = std::max(scale, std::abs(a[k]));
+	//
+	// Gauss-Jordan elimination without pivoting on all lanes at once, the smallest pivot relative to the largest entry
+	// of the block decides whether a lane is redone with pivoting
+	//
+	VectorizedArray<double> min_pivot_ratio = make_vectorized_array(1.0);
+
+	for (unsigned int k=0; k<n; ++k){
+
+		const VectorizedArray<double> pivot = a[k*n + k];
+		min_pivot_ratio = std::min(min_pivot_ratio, std::abs(pivot)/scale);
+
+		const VectorizedArray<double> inverse_pivot = 1.0/pivot;
+		a[k*n + k] = 1.0;
+		for (unsigned int j=0; j<n; ++j)
+			a[k*n + j] *= inverse_pivot;
+
+		for (unsigned int i=0; i<n; ++i){
+			if (i == k)
+				continue;
+			const VectorizedArray<double> factor = a[i*n + k];
+			a[i*n + k] = 0.0;
+			for (unsigned int j=0; j<n; ++j)
+				a[i*n + j] -= factor*a[k*n + j];
+		}
+	}
+
+	for (unsigned int lane=0; lane<n_lanes; ++lane){
+
+		if (min_pivot_ratio[lane] > 1e-8)
+			continue;
+
+		FullMatrix<double> block(n, n);
+		for (unsigned int i=0; i<n; ++i)
+			for (unsigned int j=0; j<n; ++j)
+				block(i,j) = original[i*n + j][lane];
+
+		block.gauss_jordan();
+
+		for (unsigned int i=0; i<n; ++i)
+			for (unsigned int j=0; j<n; ++j)
+				a[i*n + j][lane] = block(i,j);
+	}
+
+}
+
+}
+DEAL_II_NAMESPACE_CLOSE
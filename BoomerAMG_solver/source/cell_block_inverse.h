@@ -0,0 +1,100 @@
+#ifndef cell_block_inverse_h
+#define cell_block_inverse_h
+
+#include <deal.II/base/config.h>
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/vectorization.h>
+#include <deal.II/lac/generic_linear_algebra.h>
+
+DEAL_II_NAMESPACE_OPEN
+
+namespace TrilinosWrappers {
+
+/**
+ * Inverses of the diagonal blocks of a matrix whose unknowns are numbered cell by cell, e.g. a discontinuous Galerkin
+ * discretization where the block of a cell couples its own degrees of freedom. The blocks are used to scale the system
+ * from the left before it is handed to AIR, which works best on block diagonally scaled operators.
+ *
+ * The blocks of the locally owned rows are extracted in a single pass over the rows of the Trilinos matrix, each row is
+ * read once without searching for the entries. The blocks are then inverted in batches of the SIMD width of
+ * VectorizedArray by Gauss-Jordan elimination, which needs no pivoting as long as the blocks are well conditioned, like
+ * the cell blocks of the upwind discretization. A block whose pivots become small is inverted again with pivoting by
+ * FullMatrix::gauss_jordan. The inverted blocks are stored contiguously, one batch after the other.
+ *
+ * The locally owned range of every process must consist of whole blocks.
+ *
+ * @ingroup TrilinosWrappers
+ */
+class CellBlockInverse{
+public:
+	/**
+	 * Extract and invert the diagonal blocks of size @p block_size of the locally owned rows of @p A
+	 */
+	void initialize(const LinearAlgebraTrilinos::MPI::SparseMatrix & A,
+					const unsigned int block_size);
+
+	/**
+	 * Number of locally owned blocks
+	 */
+	unsigned int n_blocks() const;
+
+	/**
+	 * Size of the blocks
+	 */
+	unsigned int get_block_size() const;
+
+	/**
+	 * Entry (i,j) of the inverse of local block @p block
+	 */
+	double operator()(const unsigned int block,
+					  const unsigned int i,
+					  const unsigned int j) const;
+
+	/**
+	 * Multiply @p src by the block diagonal matrix of the inverses, @p dst and @p src must not be the same vector
+	 */
+	void vmult(LinearAlgebraTrilinos::MPI::Vector & dst,
+			   const LinearAlgebraTrilinos::MPI::Vector & src) const;
+
+	/**
+	 * Multiply the locally owned rows of @p A in place by the block diagonal matrix of the inverses, without forming a
+	 * second matrix. All rows of a block must have the same sparsity pattern, which holds for the flux sparsity pattern
+	 * of a discontinuous discretization, since the scaled rows have to fit into it. @p A must be the matrix the blocks
+	 * were extracted from, or have its parallel layout.
+	 */
+	void scale_rows(LinearAlgebraTrilinos::MPI::SparseMatrix & A) const;
+
+private:
+	/**
+	 * Invert the blocks of batch @p batch in place
+	 */
+	void invert_batch(const unsigned int batch);
+
+	/**
+	 * Size of the blocks
+	 */
+	unsigned int block_size = 0;
+
+	/**
+	 * Number of locally owned blocks
+	 */
+	unsigned int n_local_blocks = 0;
+
+	/**
+	 * First locally owned row
+	 */
+	types::global_dof_index first_row = 0;
+
+	/**
+	 * The blocks, entry (i,j) of block b is stored in lane b % n_lanes of element
+	 * <tt>(b / n_lanes) block_size^2 + i block_size + j</tt>
+	 */
+	AlignedVector<VectorizedArray<double>> blocks;
+
+};
+
+} // Close namespace TrilinosWrappers
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
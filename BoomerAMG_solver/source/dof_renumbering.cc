@@ -0,0 +1,130 @@
+#include <dof_renumbering.h>
+
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/mpi.h>
+#include <deal.II/dofs/dof_accessor.h>
+#include <deal.II/dofs/dof_renumbering.h>
+
+#include <Epetra_CrsMatrix.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+DEAL_II_NAMESPACE_OPEN
+
+namespace BoomerAMGDrivers
+{
+
+
+template <int dim>
+void renumber_dofs(DoFHandler<dim> & dof_handler,const std::string & strategy,const Tensor<1,dim> & direction){
+
+	if (strategy == "none")
+		return;
+
+	if (strategy == "Cuthill-McKee"){
+		DoFRenumbering::Cuthill_McKee(dof_handler);
+		return;
+	}
+
+	if (strategy == "downstream"){
+		AssertThrow(direction.norm() > 0.0, ExcMessage("The downstream renumbering needs a direction."));
+		DoFRenumbering::downstream(dof_handler, direction);
+		return;
+	}
+
+	AssertThrow(strategy == "Hilbert", ExcMessage("Unknown renumbering " + strategy));
+	//
+	// the cells are sorted by the Hilbert index of their centers, the index of all dimensions has to fit into 64 bits
+	//
+	const int bits_per_dim = 64/dim;
+
+	std::vector<typename DoFHandler<dim>::active_cell_iterator> cells;
+	std::vector<Point<dim>> centers;
+
+	for (const auto & cell : dof_handler.active_cell_iterators())
+		if (cell->is_locally_owned()){
+			cells.push_back(cell);
+			centers.push_back(cell->center());
+		}
+
+	const std::vector<std::array<std::uint64_t,dim>> hilbert_indices =
+			Utilities::inverse_Hilbert_space_filling_curve(centers, bits_per_dim);
+
+	std::vector<std::pair<std::uint64_t,unsigned int>> keys(cells.size());
+	for (unsigned int c=0; c<cells.size(); ++c)
+		keys[c] = {Utilities::pack_integers<dim>(hilbert_indices[c], bits_per_dim), c};
+
+	std::sort(keys.begin(), keys.end());
+
+	std::vector<typename DoFHandler<dim>::active_cell_iterator> cell_order;
+	cell_order.reserve(cells.size());
+	for (const auto & key : keys)
+		cell_order.push_back(cells[key.second]);
+
+	DoFRenumbering::cell_wise(dof_handler, cell_order);
+
+}
+
+std::string renumbering_strategies(const bool with_direction){
+
+	return with_direction ? "none|Cuthill-McKee|Hilbert|downstream" : "none|Cuthill-McKee|Hilbert";
+
+}
+
+BandwidthStatistics BandwidthStatistics::compute(const LinearAlgebraTrilinos::MPI::SparseMatrix & A){
+
+	const MPI_Comm communicator = A.get_mpi_communicator();
+	const Epetra_CrsMatrix & matrix = A.trilinos_matrix();
+
+	types::global_dof_index bandwidth = 0;
+	double row_bandwidth_sum = 0.0, profile = 0.0;
+
+	for (int row=0; row<matrix.NumMyRows(); ++row){
+
+		const long long int global_row = matrix.GRID64(row);
+
+		int n_entries;
+		double * values;
+		int * indices;
+		matrix.ExtractMyRowView(row, n_entries, values, indices);
+
+		long long int first_column = global_row;
+		types::global_dof_index row_bandwidth = 0;
+
+		for (int k=0; k<n_entries; ++k){
+			const long long int column = matrix.GCID64(indices[k]);
+			first_column = std::min(first_column, column);
+			row_bandwidth = std::max<types::global_dof_index>(row_bandwidth, std::abs(global_row - column));
+		}
+
+		bandwidth = std::max(bandwidth, row_bandwidth);
+		row_bandwidth_sum += row_bandwidth;
+		profile += global_row - first_column;
+	}
+
+	BandwidthStatistics statistics;
+	statistics.bandwidth = Utilities::MPI::max(bandwidth, communicator);
+	statistics.average_bandwidth = Utilities::MPI::sum(row_bandwidth_sum, communicator)/A.m();
+	statistics.profile = Utilities::MPI::sum(profile, communicator);
+
+	return statistics;
+
+}
+
+void BandwidthStatistics::print(std::ostream & out) const{
+
+	out << "Bandwidth: " << bandwidth << ", average row bandwidth: " << average_bandwidth
+		<< ", profile: " << profile << std::endl;
+
+}
+
+
+template void renumber_dofs<2>(DoFHandler<2> &, const std::string &, const Tensor<1,2> &);
+template void renumber_dofs<3>(DoFHandler<3> &, const std::string &, const Tensor<1,3> &);
+
+}
+DEAL_II_NAMESPACE_CLOSE
@@ -0,0 +1,70 @@
+#ifndef dof_renumbering_h
+#define dof_renumbering_h
+
+#include <deal.II/base/config.h>
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/tensor.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/lac/generic_linear_algebra.h>
+
+#include <ostream>
+#include <string>
+
+DEAL_II_NAMESPACE_OPEN
+
+namespace BoomerAMGDrivers {
+
+/**
+ * Renumber the degrees of freedom of @p dof_handler after DoFHandler::distribute_dofs with one of the strategies
+ * - <tt>none</tt>: keep the numbering of distribute_dofs,
+ * - <tt>Cuthill-McKee</tt>: DoFRenumbering::Cuthill_McKee, which minimizes the bandwidth,
+ * - <tt>Hilbert</tt>: number the locally owned cells along a Hilbert curve through their centers and the dofs cell by
+ *   cell, which keeps dofs close in space close in memory,
+ * - <tt>downstream</tt>: DoFRenumbering::downstream along @p direction, e.g. the velocity of an advection problem.
+ *
+ * The strategies only reorder the dofs within the locally owned range of every process.
+ */
+template <int dim>
+void renumber_dofs(DoFHandler<dim> & dof_handler,
+				   const std::string & strategy,
+				   const Tensor<1,dim> & direction = Tensor<1,dim>());
+
+/**
+ * Pattern for the strategies of renumber_dofs, <tt>none|Cuthill-McKee|Hilbert</tt>, and <tt>|downstream</tt> if
+ * @p with_direction is true
+ */
+std::string renumbering_strategies(const bool with_direction);
+
+/**
+ * Bandwidth and profile of a matrix, which indicate how well a dof numbering keeps the couplings of a row close to the
+ * diagonal, and so how local the accesses to the vector are in a matrix vector product
+ */
+struct BandwidthStatistics{
+	/**
+	 * Largest distance <tt>|i-j|</tt> of a nonzero entry (i,j) from the diagonal
+	 */
+	types::global_dof_index bandwidth = 0;
+	/**
+	 * Average over the rows of the largest distance of an entry of the row from the diagonal
+	 */
+	double average_bandwidth = 0.0;
+	/**
+	 * Profile, or envelope size, the sum over the rows of the distance of the first nonzero entry from the diagonal
+	 */
+	double profile = 0.0;
+
+	/**
+	 * Compute the statistics of the sparsity pattern of @p A. This function is collective.
+	 */
+	static BandwidthStatistics compute(const LinearAlgebraTrilinos::MPI::SparseMatrix & A);
+
+	/**
+	 * Print the statistics in a single line
+	 */
+	void print(std::ostream & out) const;
+};
+
+} // Close namespace BoomerAMGDrivers
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
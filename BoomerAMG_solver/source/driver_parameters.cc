@@ -0,0 +1,66 @@
+#include <driver_parameters.h>
+
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/mpi.h>
+
+#include <iostream>
+#include <vector>
+
+DEAL_II_NAMESPACE_OPEN
+
+namespace BoomerAMGDrivers
+{
+
+
+bool parse_command_line(ParameterHandler & prm,const int argc,char ** argv){
+
+	const bool is_first_process = (Utilities::MPI::this_mpi_process(MPI_COMM_WORLD) == 0);
+
+	for (int i=1; i<argc; ++i){
+
+		const std::string argument(argv[i]);
+
+		if (argument == "--set"){
+			AssertThrow(i+1 < argc, ExcMessage("--set needs an argument of the form Section/Entry=value."));
+			set_parameter(prm, argv[++i]);
+		}else if (argument.compare(0, 6, "--set=") == 0){
+			set_parameter(prm, argument.substr(6));
+		}else if (argument == "--print-parameters"){
+			if (is_first_process)
+				prm.print_parameters(std::cout, ParameterHandler::Text);
+			return false;
+		}else if (argument == "--help"){
+			if (is_first_process)
+				std::cout << "Usage: " << argv[0] << " [file.prm] [--set \"Section/Entry=value\"] ... [--print-parameters]\n"
+						  << "Arguments are applied in order, later ones override earlier ones." << std::endl;
+			return false;
+		}else{
+			AssertThrow(argument.compare(0, 2, "--") != 0, ExcMessage("Unknown option " + argument + ", see --help."));
+			prm.parse_input(argument);
+		}
+	}
+
+	return true;
+
+}
+
+void set_parameter(ParameterHandler & prm,const std::string & setting){
+
+	const std::string::size_type equal_sign = setting.find('=');
+	AssertThrow(equal_sign != std::string::npos, ExcMessage("Expected Section/Entry=value, got " + setting));
+
+	const std::vector<std::string> path = Utilities::split_string_list(setting.substr(0, equal_sign), '/');
+	AssertThrow(!path.empty(), ExcMessage("Expected Section/Entry=value, got " + setting));
+
+	for (unsigned int s=0; s+1<path.size(); ++s)
+		prm.enter_subsection(path[s]);
+
+	prm.set(path.back(), Utilities::trim(setting.substr(equal_sign+1)));
+
+	for (unsigned int s=0; s+1<path.size(); ++s)
+		prm.leave_subsection();
+
+}
+
+}
+DEAL_II_NAMESPACE_CLOSE
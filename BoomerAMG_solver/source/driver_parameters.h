@@ -0,0 +1,44 @@
+#ifndef driver_parameters_h
+#define driver_parameters_h
+
+#include <deal.II/base/config.h>
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/parameter_handler.h>
+
+#include <string>
+
+DEAL_II_NAMESPACE_OPEN
+
+/**
+ * Utilities shared by the example drivers, i.e. command line handling, scaling studies and dof renumbering. They do not
+ * wrap Trilinos, so they are kept apart from the solver wrappers in TrilinosWrappers.
+ */
+namespace BoomerAMGDrivers {
+
+/**
+ * Read the configuration of an example driver from its command line into @p prm, whose entries must have been declared.
+ * The arguments are processed in order:
+ * - <tt>file.prm</tt> reads a parameter file with ParameterHandler::parse_input,
+ * - <tt>--set "Section/Entry=value"</tt> sets a single entry, e.g. <tt>--set "Mesh/Refinements=7"</tt>,
+ * - <tt>--print-parameters</tt> prints all parameters with their current values and documentation,
+ * - <tt>--help</tt> prints the usage.
+ *
+ * Later arguments override earlier ones, so a sweep can share one parameter file and vary single entries with --set.
+ * Only the first process of MPI_COMM_WORLD prints. Returns false if the driver should exit without running, i.e. after
+ * --print-parameters or --help.
+ */
+bool parse_command_line(ParameterHandler & prm,
+						const int argc,
+						char ** argv);
+
+/**
+ * Set the entry given by @p setting in the form <tt>Section/Subsection/Entry=value</tt>. An exception is thrown if the
+ * entry is not declared or the value does not match its pattern.
+ */
+void set_parameter(ParameterHandler & prm,
+				   const std::string & setting);
+
+} // Close namespace BoomerAMGDrivers
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
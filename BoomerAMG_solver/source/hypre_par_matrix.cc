@@ -0,0 +1,173 @@
+#include <hypre_par_matrix.h>
+
+DEAL_II_NAMESPACE_OPEN
+
+namespace TrilinosWrappers
+{
+
+
+HypreParMatrix::~HypreParMatrix(){
+
+	clear();
+
+}
+
+void HypreParMatrix::reinit(const IndexSet & locally_owned_rows,const DynamicSparsityPattern & sparsity_pattern,const MPI_Comm & communicator){
+
+	AssertThrow(locally_owned_rows.is_contiguous(), ExcMessage("hypre requires each process to own a contiguous range of rows."));
+
+	clear();
+
+	this->locally_owned_rows = locally_owned_rows;
+	this->communicator = communicator;
+
+	const HYPRE_Int n_local_rows = locally_owned_rows.n_elements();
+	const HYPRE_Int ilower = (n_local_rows > 0) ? locally_owned_rows.nth_index_in_set(0) : 0;
+	const HYPRE_Int iupper = ilower + n_local_rows - 1;
+
+	HYPRE_IJMatrixCreate(communicator, ilower, iupper, ilower, iupper, &ij_matrix);
+	HYPRE_IJMatrixSetObjectType(ij_matrix, HYPRE_PARCSR);
+	//
+	// preallocate the diagonal and off diagonal blocks from the sparsity pattern and count the entries
+	// this process will send to other processes during assembly
+	//
+	std::vector<HYPRE_Int> diag_sizes(n_local_rows,0), offd_sizes(n_local_rows,0);
+	HYPRE_Int n_off_proc_entries = 0;
+
+	const IndexSet stored_rows = (sparsity_pattern.row_index_set().size() == 0) ?
+			complete_index_set(sparsity_pattern.n_rows()) : sparsity_pattern.row_index_set();
+
+	for (auto row_index = stored_rows.begin(); row_index != stored_rows.end(); ++row_index){
+
+		const size_type row = *row_index;
+
+		if (!locally_owned_rows.is_element(row)){
+			n_off_proc_entries += sparsity_pattern.row_length(row);
+			continue;
+		}
+
+		const size_type local_row = row - ilower;
+
+		for (auto entry = sparsity_pattern.begin(row); entry != sparsity_pattern.end(row); ++entry){
+			if (locally_owned_rows.is_element(entry->column()))
+				++diag_sizes[local_row];
+			else
+				++offd_sizes[local_row];
+		}
+	}
+
+	HYPRE_IJMatrixSetDiagOffdSizes(ij_matrix, diag_sizes.data(), offd_sizes.data());
+	HYPRE_IJMatrixSetMaxOffProcElmts(ij_matrix, n_off_proc_entries);
+
+	HYPRE_IJMatrixInitialize(ij_matrix);
+
+}
+
+void HypreParMatrix::clear(){
+
+	if (ij_matrix != nullptr)
+		HYPRE_IJMatrixDestroy(ij_matrix);
+
+	ij_matrix = nullptr;
+	is_assembled = false;
+	locally_owned_rows.clear();
+
+}
+
+void HypreParMatrix::add(const size_type row,const size_type n_cols,const size_type * col_indices,const double * values,const bool elide_zero_values,const bool col_indices_are_sorted){
+
+	(void) col_indices_are_sorted;
+
+	Assert(ij_matrix != nullptr, ExcMessage("reinit must be called before adding entries."));
+
+	column_buffer.clear();
+	value_buffer.clear();
+
+	for (size_type i=0;i<n_cols;++i){
+		if (elide_zero_values && values[i] == 0.0)
+			continue;
+		column_buffer.push_back(col_indices[i]);
+		value_buffer.push_back(values[i]);
+	}
+
+	if (column_buffer.empty())
+		return;
+
+	HYPRE_Int n_entries = column_buffer.size();
+	HYPRE_Int hypre_row = row;
+
+	HYPRE_IJMatrixAddToValues(ij_matrix, 1, &n_entries, &hypre_row, column_buffer.data(), value_buffer.data());
+
+	is_assembled = false;
+
+}
+
+void HypreParMatrix::add(const size_type i,const size_type j,const double value){
+
+	add(i, 1, &j, &value, false);
+
+}
+
+HypreParMatrix & HypreParMatrix::operator=(const double d){
+
+	(void) d;
+	Assert(d==0.0, ExcMessage("Only zero may be assigned to a HypreParMatrix."));
+
+	HYPRE_IJMatrixSetConstantValues(ij_matrix, 0.0);
+	//
+	// reopen the matrix so that entries for off process rows can be added again
+	//
+	HYPRE_IJMatrixInitialize(ij_matrix);
+	is_assembled = false;
+
+	return *this;
+
+}
+
+void HypreParMatrix::compress(const VectorOperation::values operation){
+
+	(void) operation;
+	Assert(operation == VectorOperation::add, ExcMessage("HypreParMatrix only supports VectorOperation::add."));
+
+	HYPRE_IJMatrixAssemble(ij_matrix);
+	is_assembled = true;
+
+}
+
+HypreParMatrix::size_type HypreParMatrix::m() const{
+
+	return locally_owned_rows.size();
+
+}
+
+HypreParMatrix::size_type HypreParMatrix::n() const{
+
+	return locally_owned_rows.size();
+
+}
+
+const IndexSet & HypreParMatrix::locally_owned_range_indices() const{
+
+	return locally_owned_rows;
+
+}
+
+MPI_Comm HypreParMatrix::get_mpi_communicator() const{
+
+	return communicator;
+
+}
+
+HYPRE_ParCSRMatrix HypreParMatrix::par_csr_matrix() const{
+
+	AssertThrow(is_assembled, ExcMessage("compress must be called before the hypre matrix is used."));
+
+	HYPRE_ParCSRMatrix par_matrix;
+	HYPRE_IJMatrixGetObject(ij_matrix, (void **) &par_matrix);
+
+	return par_matrix;
+
+}
+
+}
+DEAL_II_NAMESPACE_CLOSE
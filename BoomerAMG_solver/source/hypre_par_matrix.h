@@ -0,0 +1,162 @@
+#ifndef hypre_par_matrix_h
+#define hypre_par_matrix_h
+
+#include <HYPRE_IJ_mv.h>
+#include <HYPRE_parcsr_mv.h>
+
+#include <deal.II/base/config.h>
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/index_set.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/vector_operation.h>
+
+#include <vector>
+
+DEAL_II_NAMESPACE_OPEN
+
+namespace TrilinosWrappers {
+
+/**
+ * A distributed sparse matrix stored directly in hypre's IJ/ParCSR format. Matrices assembled into an instance of this class
+ * can be handed to SolverBoomerAMG::initialize without the Epetra to hypre copy performed by Ifpack_Hypre, so only a single
+ * copy of the matrix exists in memory.
+ *
+ * The class provides the subset of the deal.II matrix interface needed for assembly, in particular the add function used by
+ * AffineConstraints::distribute_local_to_global. Entries may be added to rows owned by other processes; hypre communicates
+ * them when compress() is called. As for the Trilinos matrices, compress(VectorOperation::add) must be called after assembly
+ * and before the matrix is used. deal.II only instantiates AffineConstraints::distribute_local_to_global for its own matrix
+ * types, so the file assembling into a HypreParMatrix must include <deal.II/lac/affine_constraints.templates.h>.
+ *
+ * hypre requires that each process owns a contiguous range of rows, so the locally owned index set must be contiguous.
+ *
+ * @ingroup TrilinosWrappers
+ */
+class HypreParMatrix{
+public:
+	/**
+	 * Declare the type for container size.
+	 */
+	typedef types::global_dof_index size_type;
+
+	/**
+	 * Constructor. Creates an empty matrix, reinit must be called before use.
+	 */
+	HypreParMatrix() = default;
+
+	/**
+	 * The matrix owns hypre data and may not be copied.
+	 */
+	HypreParMatrix(const HypreParMatrix &) = delete;
+
+	/**
+	 * The matrix owns hypre data and may not be copied.
+	 */
+	HypreParMatrix & operator=(const HypreParMatrix &) = delete;
+
+	/**
+	 * Destructor. Frees the hypre data.
+	 */
+	~HypreParMatrix();
+
+	/**
+	 * Create a square matrix with the rows in @p locally_owned_rows stored on this process. The number of entries in the
+	 * diagonal and off diagonal blocks of each locally owned row is taken from @p sparsity_pattern, so hypre allocates its
+	 * storage exactly once. @p sparsity_pattern should be the pattern after SparsityTools::distribute_sparsity_pattern.
+	 */
+	void reinit(const IndexSet & locally_owned_rows,
+				const DynamicSparsityPattern & sparsity_pattern,
+				const MPI_Comm & communicator);
+
+	/**
+	 * Release all hypre data.
+	 */
+	void clear();
+
+	/**
+	 * Add the @p n_cols values in @p values to row @p row at the columns given by @p col_indices. If @p elide_zero_values
+	 * is true, zero values are not sent to hypre. @p col_indices_are_sorted is accepted for interface compatibility with
+	 * the deal.II matrices and ignored.
+	 */
+	void add(const size_type row,
+			 const size_type n_cols,
+			 const size_type * col_indices,
+			 const double * values,
+			 const bool elide_zero_values = true,
+			 const bool col_indices_are_sorted = false);
+
+	/**
+	 * Add @p value to the entry (i,j)
+	 */
+	void add(const size_type i,
+			 const size_type j,
+			 const double value);
+
+	/**
+	 * Set all entries to @p d, which must be zero. Assembly can then start again without reallocating the matrix.
+	 */
+	HypreParMatrix & operator=(const double d);
+
+	/**
+	 * Finish assembly by communicating entries added to rows owned by other processes. Only VectorOperation::add is
+	 * supported.
+	 */
+	void compress(const VectorOperation::values operation);
+
+	/**
+	 * Number of rows
+	 */
+	size_type m() const;
+
+	/**
+	 * Number of columns
+	 */
+	size_type n() const;
+
+	/**
+	 * Return the rows stored on this process
+	 */
+	const IndexSet & locally_owned_range_indices() const;
+
+	/**
+	 * Return the MPI communicator of the matrix
+	 */
+	MPI_Comm get_mpi_communicator() const;
+
+	/**
+	 * Return the assembled hypre ParCSR matrix. compress() must have been called.
+	 */
+	HYPRE_ParCSRMatrix par_csr_matrix() const;
+
+private:
+	/**
+	 * The hypre IJ matrix holding the data
+	 */
+	HYPRE_IJMatrix ij_matrix = nullptr;
+
+	/**
+	 * Rows owned by this process
+	 */
+	IndexSet locally_owned_rows;
+
+	/**
+	 * MPI communicator of the matrix
+	 */
+	MPI_Comm communicator = MPI_COMM_NULL;
+
+	/**
+	 * True between compress() and the next modification of the matrix
+	 */
+	bool is_assembled = false;
+
+	/**
+	 * Buffers used by add to convert indices to the hypre index type
+	 */
+	std::vector<HYPRE_Int> column_buffer;
+	std::vector<double> value_buffer;
+
+};
+
+} // Close namespace TrilinosWrappers
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
@@ -0,0 +1,193 @@
+#include <scaling_study.h>
+
+#include <deal.II/base/utilities.h>
+
+#include <fstream>
+#include <iomanip>
+
+DEAL_II_NAMESPACE_OPEN
+
+namespace BoomerAMGDrivers
+{
+
+
+ScalingStudy::ScalingStudy(const std::string & name,const scaling_mode mode,const unsigned int base_refinements,
+		const unsigned int dim,const MPI_Comm & communicator)
+:
+name(name),
+mode(mode),
+base_refinements(base_refinements),
+dim(dim),
+communicator(communicator)
+{}
+
+ScalingStudy::scaling_mode ScalingStudy::parse_mode(const std::string & mode){
+
+	if (mode == "none")
+		return NONE;
+	else if (mode == "weak")
+		return WEAK;
+	else if (mode == "strong")
+		return STRONG;
+
+	AssertThrow(false, ExcMessage("Unknown scaling mode " + mode + ", use none, weak or strong."));
+	return NONE;
+
+}
+
+bool ScalingStudy::active() const{
+
+	return mode != NONE;
+
+}
+
+unsigned int ScalingStudy::n_refinements() const{
+
+	if (mode != WEAK)
+		return base_refinements;
+	//
+	// one refinement multiplies the number of cells by 2^dim
+	//
+	const unsigned int n_mpi_processes = Utilities::MPI::n_mpi_processes(communicator);
+	const unsigned int growth = 1u << dim;
+
+	unsigned int extra_refinements = 0;
+	for (unsigned int n=growth; n<=n_mpi_processes; n*=growth)
+		++extra_refinements;
+
+	return base_refinements + extra_refinements;
+
+}
+
+void ScalingStudy::set_problem_size(const types::global_dof_index n_dofs){
+
+	this->n_dofs = n_dofs;
+
+}
+
+void ScalingStudy::add_phase_time(const std::string & phase,const double time){
+
+	for (auto & phase_time : phase_times)
+		if (phase_time.first == phase){
+			phase_time.second += time;
+			return;
+		}
+
+	phase_times.push_back({phase, time});
+
+}
+
+std::string ScalingStudy::mode_name() const{
+
+	switch(mode)
+	{
+	case WEAK:
+		return "weak";
+	case STRONG:
+		return "strong";
+	case NONE:
+		break;
+	}
+
+	return "none";
+
+}
+
+std::vector<ScalingStudy::Entry> ScalingStudy::read_entries(const std::string & filename){
+
+	std::vector<Entry> entries;
+
+	std::ifstream in(filename);
+	if (!in)
+		return entries;
+
+	std::string line;
+	while (std::getline(in, line)){
+
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		const std::vector<std::string> fields = Utilities::split_string_list(line, ',');
+		if (fields.size() != 7 || fields[0] == "name")
+			continue;
+
+		Entry entry;
+		entry.name = fields[0];
+		entry.mode = fields[1];
+		entry.n_mpi_processes = Utilities::string_to_int(fields[2]);
+		entry.n_refinements = Utilities::string_to_int(fields[3]);
+		entry.n_dofs = Utilities::string_to_double(fields[4]);
+		entry.phase = fields[5];
+		entry.time = Utilities::string_to_double(fields[6]);
+
+		entries.push_back(entry);
+	}
+
+	return entries;
+
+}
+
+void ScalingStudy::report(const std::string & filename,std::ostream & out) const{
+
+	std::vector<double> times;
+	for (const auto & phase_time : phase_times)
+		times.push_back(phase_time.second);
+
+	std::vector<double> max_times(times.size());
+	Utilities::MPI::max(times, communicator, max_times);
+
+	if (Utilities::MPI::this_mpi_process(communicator) != 0)
+		return;
+
+	const unsigned int n_mpi_processes = Utilities::MPI::n_mpi_processes(communicator);
+	const std::vector<Entry> entries = read_entries(filename);
+
+	out << std::endl << mode_name() << " scaling of " << name << " on " << n_mpi_processes << " processes, "
+		<< n_refinements() << " refinements, " << n_dofs << " dofs" << std::endl;
+	out << "  " << std::left << std::setw(16) << "phase" << std::setw(14) << "time" << std::setw(18) << "reference time"
+		<< std::setw(20) << "reference processes" << "efficiency" << std::endl;
+
+	for (unsigned int p=0; p<phase_times.size(); ++p){
+		//
+		// the reference is the launch with the fewest processes, for strong scaling on the same mesh
+		//
+		Entry reference;
+		reference.n_mpi_processes = n_mpi_processes;
+		reference.n_dofs = n_dofs;
+		reference.time = max_times[p];
+
+		for (const auto & entry : entries)
+			if (entry.name == name && entry.mode == mode_name() && entry.phase == phase_times[p].first
+					&& (mode != STRONG || entry.n_dofs == n_dofs)
+					&& entry.n_mpi_processes < reference.n_mpi_processes)
+				reference = entry;
+
+		double efficiency = 0.0;
+		if (max_times[p] > 0.0){
+			if (mode == STRONG)
+				efficiency = (reference.time*reference.n_mpi_processes)/(max_times[p]*n_mpi_processes);
+			else if (reference.n_dofs > 0)
+				efficiency = (reference.time*n_dofs*reference.n_mpi_processes)/(max_times[p]*reference.n_dofs*n_mpi_processes);
+		}
+
+		out << "  " << std::left << std::setw(16) << phase_times[p].first << std::setw(14) << max_times[p]
+			<< std::setw(18) << reference.time << std::setw(20) << reference.n_mpi_processes << efficiency << std::endl;
+	}
+
+	const bool new_file = !std::ifstream(filename);
+
+	std::ofstream results(filename, std::ios::app);
+	AssertThrow(results, ExcMessage("Could not open " + filename + " for writing."));
+
+	results.precision(8);
+	if (new_file)
+		results << "name,mode,n_mpi_processes,n_refinements,n_dofs,phase,time\n";
+
+	for (unsigned int p=0; p<phase_times.size(); ++p)
+		results << name << ',' << mode_name() << ',' << n_mpi_processes << ',' << n_refinements() << ','
+				<< n_dofs << ',' << phase_times[p].first << ',' << max_times[p] << '\n';
+
+}
+
+}
+DEAL_II_NAMESPACE_CLOSE
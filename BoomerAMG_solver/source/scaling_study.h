@@ -0,0 +1,174 @@
+#ifndef scaling_study_h
+#define scaling_study_h
+
+#include <deal.II/base/config.h>
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/mpi.h>
+#include <deal.II/base/types.h>
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+DEAL_II_NAMESPACE_OPEN
+
+namespace BoomerAMGDrivers {
+
+/**
+ * Bookkeeping for weak and strong scaling studies of the example drivers. A scaling study is a sequence of launches of the
+ * same driver with increasing numbers of MPI processes:
+ * - for a strong scaling study the mesh is fixed at the base number of global refinements,
+ * - for a weak scaling study the mesh is refined once more for every factor 2^dim in the number of processes, so that the
+ *   number of unknowns per process stays roughly constant.
+ *
+ * The driver records the wall time of each phase, e.g. setup, assembly, AMG setup, solve and output, and calls report at
+ * the end of the run. report appends the times to a results file and prints the parallel efficiency of every phase with
+ * respect to the launch with the fewest processes found in that file:
+ * - strong scaling: <tt>E = (T_ref P_ref) / (T P)</tt>
+ * - weak scaling: <tt>E = (T_ref / w_ref) / (T / w)</tt> with the work per process <tt>w = n_dofs / P</tt>, which corrects
+ *   for process counts that are not a power of 2^dim.
+ *
+ * @code
+ * BoomerAMGDrivers::ScalingStudy scaling_study("diffusion", BoomerAMGDrivers::ScalingStudy::WEAK, 6, 2, mpi_communicator);
+ * triangulation.refine_global(scaling_study.n_refinements());
+ * ...
+ * scaling_study.set_problem_size(dof_handler.n_dofs());
+ * scaling_study.add_phase_time("assembly", assembly_time);
+ * scaling_study.report("scaling_results.csv", std::cout);
+ * @endcode
+ */
+class ScalingStudy{
+public:
+	/**
+	 * Kind of scaling study
+	 */
+	enum scaling_mode {
+		/**
+		 * No scaling study, the driver runs as usual
+		 */
+		NONE,
+		/**
+		 * Refinement grows with the number of processes
+		 */
+		WEAK,
+		/**
+		 * Refinement is fixed
+		 */
+		STRONG
+	};
+
+	/**
+	 * Constructor.
+	 * @param name identifies the driver in the results file
+	 * @param mode is the kind of scaling study
+	 * @param base_refinements is the number of global refinements on a single process
+	 * @param dim is the space dimension of the mesh
+	 * @param communicator is the communicator of the driver
+	 */
+	ScalingStudy(const std::string & name,
+				 const scaling_mode mode,
+				 const unsigned int base_refinements,
+				 const unsigned int dim,
+				 const MPI_Comm & communicator);
+
+	/**
+	 * Return the mode given by a string, one of none, weak or strong
+	 */
+	static scaling_mode parse_mode(const std::string & mode);
+
+	/**
+	 * Return whether a scaling study is run
+	 */
+	bool active() const;
+
+	/**
+	 * Return the number of global refinements to use for the current number of processes. Without a scaling study and
+	 * for strong scaling this is the base number of refinements.
+	 */
+	unsigned int n_refinements() const;
+
+	/**
+	 * Set the number of unknowns of the problem
+	 */
+	void set_problem_size(const types::global_dof_index n_dofs);
+
+	/**
+	 * Record the wall time of @p phase on this process. Times recorded for the same phase are summed. The phases are
+	 * reported in the order they were first recorded.
+	 */
+	void add_phase_time(const std::string & phase,
+						const double time);
+
+	/**
+	 * Append the maximum over all processes of the phase times to @p filename and print them with the parallel efficiency
+	 * to @p out. Only the first process writes the file and prints. This function is collective.
+	 */
+	void report(const std::string & filename,
+				std::ostream & out) const;
+
+private:
+	/**
+	 * A phase time of one launch as stored in the results file
+	 */
+	struct Entry{
+		std::string name;
+		std::string mode;
+		unsigned int n_mpi_processes = 1;
+		unsigned int n_refinements = 0;
+		types::global_dof_index n_dofs = 0;
+		std::string phase;
+		double time = 0.0;
+	};
+
+	/**
+	 * Return the mode as written to the results file
+	 */
+	std::string mode_name() const;
+
+	/**
+	 * Read the entries of @p filename, if it exists
+	 */
+	static std::vector<Entry> read_entries(const std::string & filename);
+
+	/**
+	 * Name of the driver
+	 */
+	std::string name;
+
+	/**
+	 * Kind of scaling study
+	 */
+	scaling_mode mode;
+
+	/**
+	 * Number of global refinements on a single process
+	 */
+	unsigned int base_refinements;
+
+	/**
+	 * Space dimension of the mesh
+	 */
+	unsigned int dim;
+
+	/**
+	 * Communicator of the driver
+	 */
+	MPI_Comm communicator;
+
+	/**
+	 * Number of unknowns
+	 */
+	types::global_dof_index n_dofs = 0;
+
+	/**
+	 * Wall time of each phase on this process
+	 */
+	std::vector<std::pair<std::string,double>> phase_times;
+
+};
+
+} // Close namespace BoomerAMGDrivers
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
@@ -22,6 +22,8 @@
 #include <deal.II/base/function.h>
 #include <deal.II/base/timer.h>
 #include <deal.II/base/geometry_info.h>
+#include <deal.II/base/multithread_info.h>
+#include <deal.II/base/work_stream.h>
 
 #include <deal.II/lac/generic_linear_algebra.h>
 
@@ -49,6 +51,7 @@ namespace LA
 #include <deal.II/grid/grid_generator.h>
 #include <deal.II/grid/tria_accessor.h>
 #include <deal.II/grid/tria_iterator.h>
+#include <deal.II/grid/filtered_iterator.h>
 #include <deal.II/dofs/dof_handler.h>
 #include <deal.II/dofs/dof_accessor.h>
 #include <deal.II/dofs/dof_tools.h>
@@ -62,13 +65,25 @@ namespace LA
 #include <deal.II/base/utilities.h>
 #include <deal.II/base/conditional_ostream.h>
 #include <deal.II/base/index_set.h>
+#include <deal.II/base/parameter_handler.h>
 #include <deal.II/lac/sparsity_tools.h>
+#include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/solver_gmres.h>
+#include <deal.II/fe/mapping_q1.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
 #include <deal.II/distributed/tria.h>
 #include <deal.II/distributed/grid_refinement.h>
 
 #include "BoomerAMG_solver.h"
+#include "scaling_study.h"
+#include "driver_parameters.h"
+#include "dof_renumbering.h"
 
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <iostream>
 
 #include <math.h>
@@ -76,25 +91,298 @@ namespace LA
 using namespace dealii;
 
 
+/**
+ * Run time configuration, read from a parameter file and the command line. The discretization is two dimensional only.
+ */
+struct SUPGParameters
+{
+  static void declare_parameters(ParameterHandler &prm);
+  void parse_parameters(ParameterHandler &prm);
+
+  unsigned int n_refinements;
+  std::string renumbering;
+  double speed;
+  double nu;
+  bool natural_outflow;
+  bool stabilize;
+  std::string solver;
+  unsigned int max_iterations;
+  double tolerance;
+  unsigned int gmres_restart;
+  bool matrix_free;
+  std::string boomeramg_overrides;
+  unsigned int n_threads;
+  BoomerAMGDrivers::ScalingStudy::scaling_mode scaling_mode;
+  bool write_solution;
+};
+
+void SUPGParameters::declare_parameters(ParameterHandler &prm)
+{
+  prm.enter_subsection("Mesh");
+  prm.declare_entry("Refinements", "5", Patterns::Integer(1),
+                    "Number of global refinements of the square, the base for a scaling study");
+  prm.declare_entry("Renumbering", "none", Patterns::Selection(BoomerAMGDrivers::renumbering_strategies(true)),
+                    "Numbering of the dofs, downstream follows the velocity");
+  prm.leave_subsection();
+
+  prm.enter_subsection("Problem");
+  prm.declare_entry("Speed", "100", Patterns::Double(0.0), "Magnitude of the diagonal velocity");
+  prm.declare_entry("Diffusion", "1.0", Patterns::Double(0.0), "Diffusion coefficient nu");
+  prm.declare_entry("Boundary conditions", "dirichlet", Patterns::Selection("dirichlet|natural"),
+                    "Homogeneous Dirichlet conditions everywhere, or natural conditions on the outflow boundary");
+  prm.declare_entry("Stabilize", "true", Patterns::Bool(), "Use the SUPG discretization");
+  prm.leave_subsection();
+
+  prm.enter_subsection("Solver");
+  prm.declare_entry("Solver", "Direct", Patterns::Selection("Direct|AIR|BoomerAMG|GMRES-AIR"), "Linear solver");
+  prm.declare_entry("Max iterations", "200", Patterns::Integer(1), "Maximum number of iterations of the AMG solvers");
+  prm.declare_entry("Tolerance", "1e-8", Patterns::Double(0.0), "Relative tolerance of the AMG solvers");
+  prm.declare_entry("GMRES restart", "50", Patterns::Integer(1), "Krylov space dimension of GMRES-AIR");
+  prm.declare_entry("Matrix free", "false", Patterns::Bool(),
+                    "Apply the operator of GMRES-AIR matrix free, the assembled matrix is only used for the AIR hierarchy");
+  prm.declare_entry("BoomerAMG overrides", "", Patterns::Anything(),
+                    "BoomerAMG parameters in the form name = value; name = value, e.g. relax_type = 3; distance_R = 2");
+  prm.leave_subsection();
+
+  prm.enter_subsection("Parallel");
+  prm.declare_entry("Threads per process", "1", Patterns::Integer(0),
+                    "Number of threads of the cell assembly on each MPI process, 0 uses all cores");
+  prm.leave_subsection();
+
+  prm.enter_subsection("Output");
+  prm.declare_entry("Scaling mode", "none", Patterns::Selection("none|weak|strong"), "Run a scaling study");
+  prm.declare_entry("Write solution", "true", Patterns::Bool(), "Write the solution in vtu format");
+  prm.leave_subsection();
+}
+
+void SUPGParameters::parse_parameters(ParameterHandler &prm)
+{
+  prm.enter_subsection("Mesh");
+  n_refinements = prm.get_integer("Refinements");
+  renumbering = prm.get("Renumbering");
+  prm.leave_subsection();
+
+  prm.enter_subsection("Problem");
+  speed = prm.get_double("Speed");
+  nu = prm.get_double("Diffusion");
+  natural_outflow = (prm.get("Boundary conditions") == "natural");
+  stabilize = prm.get_bool("Stabilize");
+  prm.leave_subsection();
+
+  prm.enter_subsection("Solver");
+  solver = prm.get("Solver");
+  max_iterations = prm.get_integer("Max iterations");
+  tolerance = prm.get_double("Tolerance");
+  gmres_restart = prm.get_integer("GMRES restart");
+  matrix_free = prm.get_bool("Matrix free");
+  boomeramg_overrides = prm.get("BoomerAMG overrides");
+  prm.leave_subsection();
+
+  prm.enter_subsection("Parallel");
+  n_threads = prm.get_integer("Threads per process");
+  prm.leave_subsection();
+
+  prm.enter_subsection("Output");
+  scaling_mode = BoomerAMGDrivers::ScalingStudy::parse_mode(prm.get("Scaling mode"));
+  write_solution = prm.get_bool("Write solution");
+  prm.leave_subsection();
+
+  AssertThrow(!matrix_free || solver == "GMRES-AIR", ExcMessage("The matrix free operator is only used with GMRES-AIR."));
+}
+
+
+/**
+ * Matrix free application of the SUPG operator
+ *   (grad v, nu grad u) + (v + tau beta.grad v, beta.grad u)
+ * with sum factorization on linear elements. Cells are processed in batches of the SIMD width of VectorizedArray, the
+ * stabilization parameter tau is constant per cell and stored per batch. Constrained degrees of freedom are treated as
+ * identity rows. The operator has the interface needed by the deal.II Krylov solvers.
+ */
+class SUPGOperator
+{
+public:
+  typedef LinearAlgebra::distributed::Vector<double> VectorType;
+
+  /**
+   * Set up the operator for @p dof_handler, @p constraints is the constraint object of the assembled system and @p tau
+   * returns the stabilization parameter of a cell
+   */
+  void reinit(const DoFHandler<2> &dof_handler,
+              const AffineConstraints<double> &constraints,
+              const Point<2> &velocity,
+              const double nu,
+              const std::function<double(const DoFHandler<2>::cell_iterator &)> &tau);
+
+  void initialize_dof_vector(VectorType &vector) const;
+
+  void vmult(VectorType &dst, const VectorType &src) const;
+
+private:
+  void local_apply(const MatrixFree<2,double> &data,
+                   VectorType &dst,
+                   const VectorType &src,
+                   const std::pair<unsigned int,unsigned int> &cell_range) const;
+
+  MatrixFree<2,double> data;
+
+  Tensor<1,2,VectorizedArray<double>> velocity;
+  VectorizedArray<double> nu;
+  std::vector<VectorizedArray<double>> tau;
+};
+
+void SUPGOperator::reinit(const DoFHandler<2> &dof_handler,
+                          const AffineConstraints<double> &constraints,
+                          const Point<2> &velocity,
+                          const double nu,
+                          const std::function<double(const DoFHandler<2>::cell_iterator &)> &tau)
+{
+  typename MatrixFree<2,double>::AdditionalData additional_data;
+  additional_data.tasks_parallel_scheme = MatrixFree<2,double>::AdditionalData::none;
+  additional_data.mapping_update_flags = update_gradients | update_JxW_values;
+
+  data.reinit(StaticMappingQ1<2>::mapping, dof_handler, constraints, QGauss<1>(2), additional_data);
+
+  for (unsigned int d=0; d<2; ++d)
+    this->velocity[d] = velocity(d);
+  this->nu = nu;
+
+  this->tau.resize(data.n_macro_cells());
+  for (unsigned int cell=0; cell<data.n_macro_cells(); ++cell)
+    {
+      this->tau[cell] = 0.0;
+      for (unsigned int v=0; v<data.n_components_filled(cell); ++v)
+        this->tau[cell][v] = tau(data.get_cell_iterator(cell, v));
+    }
+}
+
+void SUPGOperator::initialize_dof_vector(VectorType &vector) const
+{
+  data.initialize_dof_vector(vector);
+}
+
+void SUPGOperator::vmult(VectorType &dst, const VectorType &src) const
+{
+  data.cell_loop(&SUPGOperator::local_apply, this, dst, src, true);
+
+  for (const unsigned int index : data.get_constrained_dofs())
+    dst.local_element(index) = src.local_element(index);
+}
+
+void SUPGOperator::local_apply(const MatrixFree<2,double> &data,
+                               VectorType &dst,
+                               const VectorType &src,
+                               const std::pair<unsigned int,unsigned int> &cell_range) const
+{
+  FEEvaluation<2,1> phi(data);
+
+  for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+    {
+      phi.reinit(cell);
+      phi.read_dof_values(src);
+      phi.evaluate(false, true);
+
+      for (unsigned int q=0; q<phi.n_q_points; ++q)
+        {
+          const Tensor<1,2,VectorizedArray<double>> gradient = phi.get_gradient(q);
+          const VectorizedArray<double> convection = velocity*gradient;
+
+          phi.submit_value(convection, q);
+          phi.submit_gradient(nu*gradient + tau[cell]*convection*velocity, q);
+        }
+
+      phi.integrate(true, true);
+      phi.distribute_local_to_global(dst);
+    }
+}
+
+
+/**
+ * Application of a BoomerAMG preconditioner built from the assembled matrix to the vectors of SUPGOperator. The vectors
+ * are copied to and from Trilinos vectors with the same parallel layout.
+ */
+class SUPGOperatorPreconditioner
+{
+public:
+  SUPGOperatorPreconditioner(const TrilinosWrappers::PreconditionBoomerAMG &preconditioner,
+                             const IndexSet &locally_owned_dofs,
+                             const MPI_Comm &mpi_communicator)
+  : preconditioner(preconditioner)
+  , src_copy(locally_owned_dofs, mpi_communicator)
+  , dst_copy(locally_owned_dofs, mpi_communicator)
+  {}
+
+  void vmult(SUPGOperator::VectorType &dst, const SUPGOperator::VectorType &src) const
+  {
+    std::copy(src.begin(), src.end(), src_copy.begin());
+    preconditioner.vmult(dst_copy, src_copy);
+    std::copy(dst_copy.begin(), dst_copy.end(), dst.begin());
+  }
+
+private:
+  const TrilinosWrappers::PreconditionBoomerAMG &preconditioner;
+  mutable LA::MPI::Vector src_copy;
+  mutable LA::MPI::Vector dst_copy;
+};
+
+
 class Advection_Diffusion
 {
 public:
 
   enum boundary_condition_type {HOMOGENEOUS_DIRICHLET, HOMGENEOUS_NATURAL};
-  enum solver_option {DIRECT, AIR_AMG, CLASSIC_AMG};
+  enum solver_option {DIRECT, AIR_AMG, CLASSIC_AMG, AIR_GMRES};
 
-  Advection_Diffusion(boundary_condition_type bc_type, solver_option solver_type, bool stabilize);
+  Advection_Diffusion(const SUPGParameters &parameters);
+
+  /**
+   * Disconnect from the signals of the triangulation, which outlives the stabilization cache and signals a change when
+   * it is cleared in its destructor
+   */
+  ~Advection_Diffusion();
 
   void run();
 
 private:
   void make_grid();
   void setup_system();
+  /**
+   * Per thread data of the cell assembly
+   */
+  struct AssemblyScratchData
+  {
+    AssemblyScratchData(const FiniteElement<2> &fe);
+    AssemblyScratchData(const AssemblyScratchData &scratch_data);
+
+    FEValues<2> fe_values;
+  };
+
+  /**
+   * Cell contribution handed from a thread to copy_local_to_global
+   */
+  struct AssemblyCopyData
+  {
+    FullMatrix<double> cell_matrix;
+    Vector<double> cell_rhs;
+    std::vector<types::global_dof_index> local_dof_indices;
+  };
+
   void assemble_system();
   void assemble_system_stabilized();
+  void local_assemble_system(const DoFHandler<2>::active_cell_iterator &cell,
+                             AssemblyScratchData &scratch_data,
+                             AssemblyCopyData &copy_data);
+  void local_assemble_system_stabilized(const DoFHandler<2>::active_cell_iterator &cell,
+                                        AssemblyScratchData &scratch_data,
+                                        AssemblyCopyData &copy_data);
+  void copy_local_to_global(const AssemblyCopyData &copy_data);
+  void update_stabilization_cache();
+  double compute_tau(const DoFHandler<2>::cell_iterator &cell) const;
   void solve();
+  void solve_matrix_free(LA::MPI::Vector &solution);
   void output_results() const;
 
+  const SUPGParameters parameters;
+
   MPI_Comm mpi_communicator;
   parallel::distributed::Triangulation<2> triangulation;
 
@@ -114,18 +402,48 @@ private:
   TimerOutput        computing_timer;
 
   Point<2> velocity;
-  const double speed = 100;
+  const double speed;
   const double nu;
 
   boundary_condition_type bc_type;
   solver_option solver_type;
   bool stabilize;
 
+  BoomerAMGDrivers::ScalingStudy scaling_study;
+  double amg_setup_time;
+
+  /**
+   * Geometric data of a cell used by the stabilization parameter, unit vectors of the mapped reference directions and
+   * the element lengths along them, and tau for the cached velocity and diffusion
+   */
+  struct CellStabilization
+  {
+    Tensor<1,2> n_xi;
+    Tensor<1,2> n_etta;
+    double h_xi;
+    double h_etta;
+    double tau;
+  };
+
+  /**
+   * Stabilization data of the locally owned cells indexed by the active cell index. The geometric data is cleared when
+   * the triangulation changes, tau is recomputed when the velocity or the diffusion differ from the cached values.
+   */
+  std::vector<CellStabilization> stabilization_cache;
+  Point<2> cached_velocity;
+  double cached_nu;
+
+  /**
+   * Connection clearing the stabilization cache on every change of the triangulation
+   */
+  boost::signals2::connection tria_listener;
+
 };
 
 
-Advection_Diffusion::Advection_Diffusion(boundary_condition_type bc_type, solver_option solver_type, bool stabilize)
-: mpi_communicator(MPI_COMM_WORLD)
+Advection_Diffusion::Advection_Diffusion(const SUPGParameters &parameters)
+: parameters(parameters)
+, mpi_communicator(MPI_COMM_WORLD)
 , triangulation(mpi_communicator,
                 typename Triangulation<2>::MeshSmoothing(
                   Triangulation<2>::smoothing_on_refinement |
@@ -138,20 +456,49 @@ Advection_Diffusion::Advection_Diffusion(boundary_condition_type bc_type, solver
                   pcout,
                   TimerOutput::summary,
                   TimerOutput::wall_times)
-,	nu(1.0)
-, bc_type(bc_type)
-, solver_type(solver_type)
-, stabilize(stabilize)
+, speed(parameters.speed)
+,	nu(parameters.nu)
+, bc_type(parameters.natural_outflow ? HOMGENEOUS_NATURAL : HOMOGENEOUS_DIRICHLET)
+, solver_type(parameters.solver == "AIR" ? AIR_AMG :
+              parameters.solver == "BoomerAMG" ? CLASSIC_AMG :
+              parameters.solver == "GMRES-AIR" ? AIR_GMRES : DIRECT)
+, stabilize(parameters.stabilize)
+, scaling_study("advection_diffusion_supg", parameters.scaling_mode, parameters.n_refinements, 2, mpi_communicator)
+, amg_setup_time(0.0)
+, cached_nu(0.0)
 {
 	  velocity(0) = pow(2.0,0.5)/2.0;//0.15;//pow(2.0,0.5)/2.0;
 	  velocity(1) = pow(2.0,0.5)/2.0;//0.9886859966642595;//velocity(0);
 
 	  velocity(0) *= speed;
 	  velocity(1) *= speed;
+
+	  tria_listener = triangulation.signals.any_change.connect([this](){ stabilization_cache.clear(); });
 }
 
 
 
+Advection_Diffusion::~Advection_Diffusion()
+{
+  tria_listener.disconnect();
+}
+
+
+
+Advection_Diffusion::AssemblyScratchData::AssemblyScratchData(const FiniteElement<2> &fe)
+: fe_values(fe,
+            QGauss<2>(2),
+            update_values | update_gradients | update_JxW_values)
+{}
+
+Advection_Diffusion::AssemblyScratchData::AssemblyScratchData(const AssemblyScratchData &scratch_data)
+: fe_values(scratch_data.fe_values.get_fe(),
+            scratch_data.fe_values.get_quadrature(),
+            scratch_data.fe_values.get_update_flags())
+{}
+
+
+
 void Advection_Diffusion::make_grid()
 {
   GridGenerator::hyper_cube(triangulation, -1, 1);
@@ -159,8 +506,7 @@ void Advection_Diffusion::make_grid()
 
   Vector<float> dummy_error;
 
-  //9
-  for(int i=0;i<4;++i){
+  for(unsigned int i=1;i<scaling_study.n_refinements();++i){
   	dummy_error.reinit(triangulation.n_active_cells());
   	dummy_error = 1.0;
   	parallel::distributed::GridRefinement::refine_and_coarsen_fixed_number(triangulation,dummy_error,1.0,0.0);
@@ -184,6 +530,7 @@ void Advection_Diffusion::setup_system()
     TimerOutput::Scope t(computing_timer, "setup");
 
     dof_handler.distribute_dofs(fe);
+    BoomerAMGDrivers::renumber_dofs(dof_handler, parameters.renumbering, Tensor<1,2>(velocity));
 
     locally_owned_dofs = dof_handler.locally_owned_dofs();
     DoFTools::extract_locally_relevant_dofs(dof_handler, locally_relevant_dofs);
@@ -261,189 +608,243 @@ void Advection_Diffusion::setup_system()
                          locally_owned_dofs,
                          dsp,
                          mpi_communicator);
+
+    const BoomerAMGDrivers::BandwidthStatistics bandwidth_statistics =
+      BoomerAMGDrivers::BandwidthStatistics::compute(system_matrix);
+    pcout << "Numbering " << parameters.renumbering << ". ";
+    if (pcout.is_active())
+      bandwidth_statistics.print(pcout.get_stream());
 }
 
 /**
- * This function is essentially the same as that from step 40 except that an advection
- * term has been added. Additionally, linear elements are being used.
+ * The assembly process is the same as in step 40, except that an advection term
+ * and the option for a variable diffusion coefficient nu have been added. Linear
+ * elements are used. The locally owned cells are distributed over the threads of
+ * the process by WorkStream.
  */
 void Advection_Diffusion::assemble_system(){
 
-	QGauss<2> quadrature_formula(2);
+	typedef FilteredIterator<DoFHandler<2>::active_cell_iterator> CellFilter;
 
-	FEValues<2> fe_values(fe,
-	                      quadrature_formula,
-	                      update_values | update_gradients | update_JxW_values);
+	WorkStream::run(CellFilter(IteratorFilters::LocallyOwnedCell(), dof_handler.begin_active()),
+	                CellFilter(IteratorFilters::LocallyOwnedCell(), dof_handler.end()),
+	                *this,
+	                &Advection_Diffusion::local_assemble_system,
+	                &Advection_Diffusion::copy_local_to_global,
+	                AssemblyScratchData(fe),
+	                AssemblyCopyData());
 
-	const unsigned int dofs_per_cell = fe.dofs_per_cell;
-	const unsigned int n_q_points    = quadrature_formula.size();
+	  system_matrix.compress(VectorOperation::add);
+	  system_rhs.compress(VectorOperation::add);
 
-	FullMatrix<double> cell_matrix(dofs_per_cell, dofs_per_cell);
-	Vector<double>     cell_rhs(dofs_per_cell);
 
-	std::vector<types::global_dof_index> local_dof_indices(dofs_per_cell);
+}
 
-	/**
-	 * The assembly processes is the same from step 40 except and advection term
-	 * is added and the option for a variable diffusion coefficient nu is added
-	 */
-	  for (const auto &cell : dof_handler.active_cell_iterators())
-	    {
-	      if (cell->is_locally_owned())
-	        {
+void Advection_Diffusion::local_assemble_system(const DoFHandler<2>::active_cell_iterator &cell,
+                                                AssemblyScratchData &scratch_data,
+                                                AssemblyCopyData &copy_data){
 
-			  cell_matrix = 0;
-			  cell_rhs    = 0;
+	FEValues<2> &fe_values = scratch_data.fe_values;
 
-			  fe_values.reinit(cell);
+	const unsigned int dofs_per_cell = fe.dofs_per_cell;
+	const unsigned int n_q_points    = fe_values.n_quadrature_points;
 
-			  for (unsigned int q_index = 0; q_index < n_q_points; ++q_index)
-				{
-				  for (unsigned int i = 0; i < dofs_per_cell; ++i)
-					for (unsigned int j = 0; j < dofs_per_cell; ++j){
-					  cell_matrix(i, j) +=
-						nu*(fe_values.shape_grad(i, q_index) *
-						 fe_values.shape_grad(j, q_index) *
-						 fe_values.JxW(q_index));
+	FullMatrix<double> &cell_matrix = copy_data.cell_matrix;
+	Vector<double>     &cell_rhs = copy_data.cell_rhs;
 
-					  cell_matrix(i, j) +=
-						(velocity * fe_values.shape_grad(j, q_index)) *
-						 fe_values.shape_value(i, q_index) *
-						 fe_values.JxW(q_index);
+	cell_matrix.reinit(dofs_per_cell, dofs_per_cell);
+	cell_rhs.reinit(dofs_per_cell);
+	copy_data.local_dof_indices.resize(dofs_per_cell);
 
-					}
-				  for (unsigned int i = 0; i < dofs_per_cell; ++i)
-				  {
-					cell_rhs(i) += (fe_values.shape_value(i, q_index) *
-									1.0 * fe_values.JxW(q_index));
-				  }
-				}
-
-			  cell->get_dof_indices(local_dof_indices);
-
-	          cell->get_dof_indices(local_dof_indices);
-	          constraints.distribute_local_to_global(cell_matrix,
-	                                                 cell_rhs,
-	                                                 local_dof_indices,
-	                                                 system_matrix,
-	                                                 system_rhs);
-	        }
-	    }
+	fe_values.reinit(cell);
 
-	  system_matrix.compress(VectorOperation::add);
-	  system_rhs.compress(VectorOperation::add);
+	for (unsigned int q_index = 0; q_index < n_q_points; ++q_index)
+	{
+	  for (unsigned int i = 0; i < dofs_per_cell; ++i)
+		for (unsigned int j = 0; j < dofs_per_cell; ++j){
+		  cell_matrix(i, j) +=
+			nu*(fe_values.shape_grad(i, q_index) *
+			 fe_values.shape_grad(j, q_index) *
+			 fe_values.JxW(q_index));
+
+		  cell_matrix(i, j) +=
+			(velocity * fe_values.shape_grad(j, q_index)) *
+			 fe_values.shape_value(i, q_index) *
+			 fe_values.JxW(q_index);
 
+		}
+	  for (unsigned int i = 0; i < dofs_per_cell; ++i)
+	  {
+		cell_rhs(i) += (fe_values.shape_value(i, q_index) *
+						1.0 * fe_values.JxW(q_index));
+	  }
+	}
+
+	cell->get_dof_indices(copy_data.local_dof_indices);
 
 }
+
 /**
- * This function implements an SUPG discretization. The specifics of the stabilization
- * are presented in the report.
+ * Writing to the global matrix and right hand side is serialized by WorkStream
  */
-void Advection_Diffusion::assemble_system_stabilized()
-{
-  bool stabilize = true;
-
-  QGauss<2> quadrature_formula(2);
+void Advection_Diffusion::copy_local_to_global(const AssemblyCopyData &copy_data){
 
-  FEValues<2> fe_values(fe,
-                        quadrature_formula,
-                        update_values | update_gradients | update_JxW_values);
+	constraints.distribute_local_to_global(copy_data.cell_matrix,
+	                                       copy_data.cell_rhs,
+	                                       copy_data.local_dof_indices,
+	                                       system_matrix,
+	                                       system_rhs);
 
+}
+/**
+ * Fill the stabilization cache of the locally owned cells. The mapped directions and element lengths are only computed
+ * after the triangulation changed, the upwind functions and tau only when the velocity or the diffusion changed.
+ */
+void Advection_Diffusion::update_stabilization_cache()
+{
+  const bool new_geometry = stabilization_cache.size() != triangulation.n_active_cells();
 
-  const unsigned int dofs_per_cell = fe.dofs_per_cell;
-  const unsigned int n_q_points    = quadrature_formula.size();
-
-  FullMatrix<double> cell_matrix(dofs_per_cell, dofs_per_cell);
-  Vector<double>     cell_rhs(dofs_per_cell);
+  if (!new_geometry && cached_velocity == velocity && cached_nu == nu)
+    return;
 
-  std::vector<types::global_dof_index> local_dof_indices(dofs_per_cell);
+  if (new_geometry)
+    {
+      stabilization_cache.resize(triangulation.n_active_cells());
+
+      const Mapping<2> &mapping = StaticMappingQ1<2>::mapping;
+
+      for (const auto &cell : dof_handler.active_cell_iterators())
+        if (cell->is_locally_owned())
+          {
+            CellStabilization &data = stabilization_cache[cell->active_cell_index()];
+            //
+            Point<2> zero = mapping.transform_unit_to_real_cell(cell, Point<2>(0.0,0.0));
+            data.n_xi = mapping.transform_unit_to_real_cell(cell, Point<2>(1.0,0.0)) - zero;
+            data.n_xi /= data.n_xi.norm();
+            //
+            data.n_etta = mapping.transform_unit_to_real_cell(cell, Point<2>(0.0,1.0)) - zero;
+            data.n_etta /= data.n_etta.norm();
+            //
+            Point<2> x0,x1,x2,x3;
+            //
+            x0 = cell->vertex(0);
+            x1 = cell->vertex(1);
+            x2 = cell->vertex(2);
+            x3 = cell->vertex(3);
+            //
+            data.h_xi = ( x3(0) + x1(0) - x2(0) - x0(0) )/2.0;
+            data.h_etta = ( x3(1) + x2(1) - x0(1) - x1(1) )/2.0;
+          }
+    }
+  //
+  // Compute P(w)tau
+  //
+  for (const auto &cell : dof_handler.active_cell_iterators())
+    if (cell->is_locally_owned())
+      {
+        CellStabilization &data = stabilization_cache[cell->active_cell_index()];
+        //
+        double a_xi = velocity*data.n_xi;
+        double a_etta = velocity*data.n_etta;
+        //
+        double Pe_xi = a_xi*data.h_xi/2.0/nu;
+        double Pe_etta = a_etta*data.h_etta/2.0/nu;
+        //
+        double etta_bar = 1.0/tanh(Pe_xi) - 1.0/Pe_xi;
+        double xi_bar = 1.0/tanh(Pe_etta) - 1.0/Pe_etta;
+        //
+        data.tau = (etta_bar*a_etta*data.h_etta + xi_bar*a_xi*data.h_xi)/2.0/pow(velocity.norm(),2);
+      }
 
+  cached_velocity = velocity;
+  cached_nu = nu;
+}
 
-  for (const auto &cell : dof_handler.active_cell_iterators())
-    {
-      if (cell->is_locally_owned())
-        {
-		  fe_values.reinit(cell);
-		  //
-		  Point<2> zero = fe_values.get_mapping().transform_unit_to_real_cell(cell, Point<2>(0.0,0.0));
-		  Point<2> n_xi = fe_values.get_mapping().transform_unit_to_real_cell(cell, Point<2>(1.0,0.0));
-		  n_xi -= zero;
-		  n_xi /= n_xi.norm();
-		  //
-		  Point<2> n_etta = fe_values.get_mapping().transform_unit_to_real_cell(cell, Point<2>(0.0,1.0));
-		  n_etta -= zero;
-		  n_etta /= n_etta.norm();
-		  //
-		  cell_matrix = 0;
-		  cell_rhs    = 0;
-		  //
-		  // Compute P(w)tau
-		  //
-		  Point<2> x0,x1,x2,x3;
-		  //
-		  x0 = cell->vertex(0);
-		  x1 = cell->vertex(1);
-		  x2 = cell->vertex(2);
-		  x3 = cell->vertex(3);
-		  //
-		  double h_xi = ( x3(0) + x1(0) - x2(0) - x0(0) )/2.0;
-		  double h_etta = ( x3(1) + x2(1) - x0(1) - x1(1) )/2.0;
-		  //
-		  double a_xi = velocity*n_xi;
-		  double a_etta = velocity*n_etta;
-		  //
-		  double Pe_xi = a_xi*h_xi/2.0/nu;
-		  double Pe_etta = a_etta*h_etta/2.0/nu;
-		  //
-		  double etta_bar = 1.0/tanh(Pe_xi) - 1.0/Pe_xi;
-		  double xi_bar = 1.0/tanh(Pe_etta) - 1.0/Pe_etta;
-		  //
-		  double tau = (etta_bar*a_etta*h_etta + xi_bar*a_xi*h_xi)/2.0/pow(velocity.norm(),2);
-		  //
-		  for (unsigned int q_index = 0; q_index < n_q_points; ++q_index)
-			{
-			  for (unsigned int i = 0; i < dofs_per_cell; ++i)
-				for (unsigned int j = 0; j < dofs_per_cell; ++j){
-				  cell_matrix(i, j) +=
-					nu*(fe_values.shape_grad(i, q_index) *
-					 fe_values.shape_grad(j, q_index) *
-					 fe_values.JxW(q_index));
-
-				  cell_matrix(i, j) +=
-					(velocity * fe_values.shape_grad(j, q_index) *
-					 fe_values.shape_value(i, q_index) *
-					 fe_values.JxW(q_index));
-
-				  cell_matrix(i,j) += (fe_values.shape_grad(i,q_index)*
-						  velocity)*tau*(fe_values.shape_grad(j,q_index)*velocity)
-						  *fe_values.JxW(q_index);
-
-				}
-			  for (unsigned int i = 0; i < dofs_per_cell; ++i)
-			  {
-				cell_rhs(i) += (fe_values.shape_value(i, q_index) *
-								1.0 * fe_values.JxW(q_index));
-				cell_rhs(i) += (fe_values.shape_grad(i,q_index)*velocity)*tau*fe_values.JxW(q_index);
-			  }
-			}
+/**
+ * Stabilization parameter of the SUPG discretization of @p cell, the specifics are presented in the report. The cache has
+ * to be up to date, see update_stabilization_cache.
+ */
+double Advection_Diffusion::compute_tau(const DoFHandler<2>::cell_iterator &cell) const
+{
+  return stabilization_cache[cell->active_cell_index()].tau;
+}
 
+/**
+ * This function implements an SUPG discretization. The specifics of the stabilization
+ * are presented in the report.
+ */
+void Advection_Diffusion::assemble_system_stabilized()
+{
+  //
+  // the cache is filled before the threads start, they only read it
+  //
+  update_stabilization_cache();
 
-		  cell->get_dof_indices(local_dof_indices);
+  typedef FilteredIterator<DoFHandler<2>::active_cell_iterator> CellFilter;
 
-          cell->get_dof_indices(local_dof_indices);
-          constraints.distribute_local_to_global(cell_matrix,
-                                                 cell_rhs,
-                                                 local_dof_indices,
-                                                 system_matrix,
-                                                 system_rhs);
-        }
-    }
+  WorkStream::run(CellFilter(IteratorFilters::LocallyOwnedCell(), dof_handler.begin_active()),
+                  CellFilter(IteratorFilters::LocallyOwnedCell(), dof_handler.end()),
+                  *this,
+                  &Advection_Diffusion::local_assemble_system_stabilized,
+                  &Advection_Diffusion::copy_local_to_global,
+                  AssemblyScratchData(fe),
+                  AssemblyCopyData());
 
   system_matrix.compress(VectorOperation::add);
   system_rhs.compress(VectorOperation::add);
 
 }
 
+void Advection_Diffusion::local_assemble_system_stabilized(const DoFHandler<2>::active_cell_iterator &cell,
+                                                           AssemblyScratchData &scratch_data,
+                                                           AssemblyCopyData &copy_data)
+{
+  FEValues<2> &fe_values = scratch_data.fe_values;
+
+  const unsigned int dofs_per_cell = fe.dofs_per_cell;
+  const unsigned int n_q_points    = fe_values.n_quadrature_points;
+
+  FullMatrix<double> &cell_matrix = copy_data.cell_matrix;
+  Vector<double>     &cell_rhs = copy_data.cell_rhs;
+
+  cell_matrix.reinit(dofs_per_cell, dofs_per_cell);
+  cell_rhs.reinit(dofs_per_cell);
+  copy_data.local_dof_indices.resize(dofs_per_cell);
+
+  fe_values.reinit(cell);
+  //
+  const double tau = compute_tau(cell);
+  //
+  for (unsigned int q_index = 0; q_index < n_q_points; ++q_index)
+	{
+	  for (unsigned int i = 0; i < dofs_per_cell; ++i)
+		for (unsigned int j = 0; j < dofs_per_cell; ++j){
+		  cell_matrix(i, j) +=
+			nu*(fe_values.shape_grad(i, q_index) *
+			 fe_values.shape_grad(j, q_index) *
+			 fe_values.JxW(q_index));
+
+		  cell_matrix(i, j) +=
+			(velocity * fe_values.shape_grad(j, q_index) *
+			 fe_values.shape_value(i, q_index) *
+			 fe_values.JxW(q_index));
+
+		  cell_matrix(i,j) += (fe_values.shape_grad(i,q_index)*
+				  velocity)*tau*(fe_values.shape_grad(j,q_index)*velocity)
+				  *fe_values.JxW(q_index);
+
+		}
+	  for (unsigned int i = 0; i < dofs_per_cell; ++i)
+	  {
+		cell_rhs(i) += (fe_values.shape_value(i, q_index) *
+						1.0 * fe_values.JxW(q_index));
+		cell_rhs(i) += (fe_values.shape_grad(i,q_index)*velocity)*tau*fe_values.JxW(q_index);
+	  }
+	}
+
+  cell->get_dof_indices(copy_data.local_dof_indices);
+}
+
 
 
 void Advection_Diffusion::solve()
@@ -454,19 +855,50 @@ void Advection_Diffusion::solve()
                                                     mpi_communicator);
 
     if (solver_type == AIR_AMG){
-    	TrilinosWrappers::BoomerAMGParameters AMG_parameters(TrilinosWrappers::BoomerAMGParameters::AIR_AMG, Hypre_Chooser::Solver);
+    	TrilinosWrappers::BoomerAMGParameters AMG_parameters(parameters.max_iterations, parameters.tolerance, TrilinosWrappers::BoomerAMGParameters::AIR_AMG);
         /**
          * Demonstrate changing a parameter value
          */
     	AMG_parameters.set_parameter_value("relax_type",3);
+    	AMG_parameters.set_parameter_values(parameters.boomeramg_overrides);
     	TrilinosWrappers::SolverBoomerAMG AMG_solver(AMG_parameters);
-    	AMG_solver.solve(system_matrix, system_rhs, completely_distributed_solution);
-    	AMG_solver.solve(system_matrix, system_rhs, completely_distributed_solution);
+        /**
+         * The AMG hierarchy is built once by initialize and reused by both solves
+         */
+    	AMG_solver.initialize(system_matrix);
+    	AMG_solver.solve(completely_distributed_solution, system_rhs);
+    	AMG_solver.solve(completely_distributed_solution, system_rhs);
+
+    	const auto AMG_statistics = AMG_solver.get_statistics();
+    	if (Utilities::MPI::this_mpi_process(mpi_communicator) == 0)
+    		AMG_statistics.write_json(std::cout);
+    	amg_setup_time = AMG_statistics.parameter_time + AMG_statistics.conversion_time + AMG_statistics.setup_time;
 
     }else if (solver_type == CLASSIC_AMG){
-    	TrilinosWrappers::BoomerAMGParameters AMG_parameters(TrilinosWrappers::BoomerAMGParameters::CLASSICAL_AMG, Hypre_Chooser::Solver);
+    	TrilinosWrappers::BoomerAMGParameters AMG_parameters(parameters.max_iterations, parameters.tolerance, TrilinosWrappers::BoomerAMGParameters::CLASSICAL_AMG);
+    	AMG_parameters.set_parameter_values(parameters.boomeramg_overrides);
     	TrilinosWrappers::SolverBoomerAMG AMG_solver(AMG_parameters);
-    	AMG_solver.solve(system_matrix, system_rhs, completely_distributed_solution);
+    	AMG_solver.initialize(system_matrix);
+    	AMG_solver.solve(completely_distributed_solution, system_rhs);
+
+    	const auto AMG_statistics = AMG_solver.get_statistics();
+    	amg_setup_time = AMG_statistics.parameter_time + AMG_statistics.conversion_time + AMG_statistics.setup_time;
+    }else if (solver_type == AIR_GMRES && parameters.matrix_free){
+    	solve_matrix_free(completely_distributed_solution);
+    }else if (solver_type == AIR_GMRES){
+        /**
+         * GMRES preconditioned by a single AIR V-cycle per iteration
+         */
+    	TrilinosWrappers::BoomerAMGParameters AMG_parameters(TrilinosWrappers::BoomerAMGParameters::AIR_AMG);
+    	AMG_parameters.set_parameter_values(parameters.boomeramg_overrides);
+    	TrilinosWrappers::ifpackSolverParameters solver_parameters(parameters.max_iterations, parameters.tolerance, Hypre_Solver::GMRES);
+    	solver_parameters.set_restart(parameters.gmres_restart);
+    	TrilinosWrappers::BoomerAMG_PreconditionedSolver GMRES_solver(AMG_parameters, solver_parameters);
+    	GMRES_solver.initialize(system_matrix);
+    	GMRES_solver.solve(completely_distributed_solution, system_rhs);
+
+    	const auto GMRES_statistics = GMRES_solver.get_statistics();
+    	amg_setup_time = GMRES_statistics.parameter_time + GMRES_statistics.conversion_time + GMRES_statistics.setup_time;
     } else{
         SolverControl solver_control(3000,1e-6);
     	TrilinosWrappers::SolverDirect Solv(solver_control);
@@ -483,6 +915,51 @@ void Advection_Diffusion::solve()
 
 
 
+/**
+ * GMRES with the matrix free SUPGOperator, preconditioned by a single AIR V-cycle per iteration. The assembled matrix is
+ * only used to build the AIR hierarchy.
+ */
+void Advection_Diffusion::solve_matrix_free(LA::MPI::Vector &solution)
+{
+	if (stabilize)
+		update_stabilization_cache();
+
+	SUPGOperator supg_operator;
+	supg_operator.reinit(dof_handler, constraints, velocity, nu,
+			[this](const DoFHandler<2>::cell_iterator &cell){ return stabilize ? compute_tau(cell) : 0.0; });
+
+	TrilinosWrappers::BoomerAMGParameters AMG_parameters(TrilinosWrappers::BoomerAMGParameters::AIR_AMG);
+	AMG_parameters.set_parameter_values(parameters.boomeramg_overrides);
+	TrilinosWrappers::PreconditionBoomerAMG AMG_preconditioner(AMG_parameters);
+
+	Timer timer(mpi_communicator, true);
+	AMG_preconditioner.initialize(system_matrix);
+	timer.stop();
+	amg_setup_time = Utilities::MPI::max(timer.wall_time(), mpi_communicator);
+
+	SUPGOperator::VectorType x, b;
+	supg_operator.initialize_dof_vector(x);
+	supg_operator.initialize_dof_vector(b);
+	std::copy(system_rhs.begin(), system_rhs.end(), b.begin());
+
+	//
+	// right preconditioning, so that the tolerance applies to the unpreconditioned residual as in hypre's GMRES
+	//
+	SolverGMRES<SUPGOperator::VectorType>::AdditionalData gmres_data(parameters.gmres_restart);
+	gmres_data.right_preconditioning = true;
+
+	SolverControl solver_control(parameters.max_iterations, parameters.tolerance*b.l2_norm());
+	SolverGMRES<SUPGOperator::VectorType> gmres(solver_control, gmres_data);
+
+	gmres.solve(supg_operator, x, b, SUPGOperatorPreconditioner(AMG_preconditioner, locally_owned_dofs, mpi_communicator));
+
+	std::copy(x.begin(), x.end(), solution.begin());
+
+	pcout << "Matrix free GMRES converged in " << solver_control.last_step() << " iterations" << std::endl;
+}
+
+
+
 void Advection_Diffusion::output_results() const
 {
 	int cycle=1;
@@ -524,12 +1001,40 @@ void Advection_Diffusion::output_results() const
 
 void Advection_Diffusion::run()
 {
-  make_grid();
+  {
+    TimerOutput::Scope t(computing_timer, "setup");
+    make_grid();
+  }
   setup_system();
-  assemble_system_stabilized();
-  //assemble_system();
+  {
+    TimerOutput::Scope t(computing_timer, "assembly");
+    if (stabilize)
+      assemble_system_stabilized();
+    else
+      assemble_system();
+  }
   solve();
-  output_results();
+  if (parameters.write_solution)
+  {
+    TimerOutput::Scope t(computing_timer, "output");
+    output_results();
+  }
+
+  if (scaling_study.active())
+  {
+	  /**
+	   * The AMG setup is reported separately from the iterations of the solve, the direct solver has no AMG setup
+	   */
+	  std::map<std::string, double> timings = computing_timer.get_summary_data(TimerOutput::total_wall_time);
+
+	  scaling_study.set_problem_size(dof_handler.n_dofs());
+	  scaling_study.add_phase_time("setup", timings["setup"]);
+	  scaling_study.add_phase_time("assembly", timings["assembly"]);
+	  scaling_study.add_phase_time("AMG setup", amg_setup_time);
+	  scaling_study.add_phase_time("solve", timings["solve"] - amg_setup_time);
+	  scaling_study.add_phase_time("output", timings["output"]);
+	  scaling_study.report("scaling_results.csv", std::cout);
+  }
 }
 
 
@@ -540,7 +1045,20 @@ int main(int argc, char *argv[])
 
   deallog.depth_console(2);
 
-  Advection_Diffusion laplace_problem(Advection_Diffusion::HOMOGENEOUS_DIRICHLET,Advection_Diffusion::DIRECT, true );
+  /**
+   * The configuration is read from an optional parameter file and --set options, see --help
+   */
+  ParameterHandler prm;
+  SUPGParameters::declare_parameters(prm);
+  if (!BoomerAMGDrivers::parse_command_line(prm, argc, argv))
+    return 0;
+
+  SUPGParameters parameters;
+  parameters.parse_parameters(prm);
+
+  MultithreadInfo::set_thread_limit(parameters.n_threads == 0 ? numbers::invalid_unsigned_int : parameters.n_threads);
+
+  Advection_Diffusion laplace_problem(parameters);
   laplace_problem.run();
 
   return 0;
@@ -1,6 +1,8 @@
 #include <deal.II/base/quadrature_lib.h>
 #include <deal.II/base/function.h>
 #include <deal.II/base/timer.h>
+#include <deal.II/base/multithread_info.h>
+#include <deal.II/base/work_stream.h>
 #include <deal.II/lac/generic_linear_algebra.h>
 
 #include <deal.II/lac/vector.h>
@@ -16,6 +18,7 @@
 #include <deal.II/grid/grid_generator.h>
 #include <deal.II/grid/tria_accessor.h>
 #include <deal.II/grid/tria_iterator.h>
+#include <deal.II/grid/filtered_iterator.h>
 #include <deal.II/dofs/dof_handler.h>
 #include <deal.II/dofs/dof_accessor.h>
 #include <deal.II/dofs/dof_tools.h>
@@ -27,6 +30,7 @@
 #include <deal.II/base/utilities.h>
 #include <deal.II/base/conditional_ostream.h>
 #include <deal.II/base/index_set.h>
+#include <deal.II/base/parameter_handler.h>
 #include <deal.II/lac/sparsity_tools.h>
 #include <deal.II/distributed/tria.h>
 #include <deal.II/distributed/grid_refinement.h>
@@ -35,16 +39,15 @@
 ///////////////////////////////////////////////
 //
 #include "BoomerAMG_solver.h"
+#include "scaling_study.h"
+#include "driver_parameters.h"
+#include "dof_renumbering.h"
 
 namespace LA =  dealii::LinearAlgebraTrilinos;
 
 using namespace dealii;
 
 
-//
-// Diffusion coefficients.
-//
-double diff_reg1=100.0 , diff_reg2=0.001;
 //
 // cube or box dimensions
 //
@@ -59,7 +62,8 @@ double dx=0.2;
 int nx=3;
 //
 template<int dim>
-double banded_diff_coef(typename DoFHandler<dim>::active_cell_iterator & cell){
+double banded_diff_coef(typename DoFHandler<dim>::active_cell_iterator & cell,
+                        const double outside_coefficient, const double inside_coefficient){
 
 	int vertices;
 	if (dim==2) vertices=4;
@@ -101,14 +105,117 @@ double banded_diff_coef(typename DoFHandler<dim>::active_cell_iterator & cell){
 
 	double diffusion;
 	if (region2)
-		diffusion = diff_reg2;
+		diffusion = inside_coefficient;
 	else
-		diffusion = diff_reg1;
+		diffusion = outside_coefficient;
 
 	return diffusion;
 
 }
 //
+// Run time configuration, read from a parameter file and the command line
+//
+struct DiffusionParameters
+{
+  static void declare_parameters (ParameterHandler &prm);
+  void parse_parameters (ParameterHandler &prm);
+
+  unsigned int dimension;
+  unsigned int n_refinements;
+  std::string renumbering;
+  bool banded_coefficient;
+  double outside_bands_coefficient;
+  double inside_bands_coefficient;
+  std::vector<std::string> solvers;
+  bool verify_batched_native_solve;
+  bool verify_convergence_monitor;
+  unsigned int max_iterations;
+  double tolerance;
+  double ml_tolerance;
+  std::string boomeramg_overrides;
+  unsigned int n_threads;
+  BoomerAMGDrivers::ScalingStudy::scaling_mode scaling_mode;
+  bool write_solution;
+};
+
+void DiffusionParameters::declare_parameters (ParameterHandler &prm)
+{
+  prm.enter_subsection ("Mesh");
+  prm.declare_entry ("Dimension", "2", Patterns::Integer(2,3), "Space dimension");
+  prm.declare_entry ("Refinements", "8", Patterns::Integer(1),
+                     "Number of global refinements of the 2^dim cell unit cube, the base for a scaling study");
+  prm.declare_entry ("Renumbering", "none", Patterns::Selection (BoomerAMGDrivers::renumbering_strategies (false)),
+                     "Numbering of the dofs");
+  prm.leave_subsection ();
+
+  prm.enter_subsection ("Coefficient");
+  prm.declare_entry ("Banded", "true", Patterns::Bool(), "Use the banded coefficient, otherwise the coefficient is 1");
+  prm.declare_entry ("Outside bands", "100.0", Patterns::Double(0.0), "Diffusion coefficient outside the bands");
+  prm.declare_entry ("Inside bands", "0.001", Patterns::Double(0.0), "Diffusion coefficient inside the bands");
+  prm.leave_subsection ();
+
+  prm.enter_subsection ("Solver");
+  prm.declare_entry ("Solvers", "CG, ICPCG, PCG, BoomerAMG, MLPCG",
+                     Patterns::List(Patterns::Selection("CG|ICPCG|PCG|BoomerAMG|MLPCG")),
+                     "Solvers run one after the other, a scaling study uses the first");
+  prm.declare_entry ("Verify batched native solve", "false", Patterns::Bool(),
+                     "Solve a block of right hand sides with BoomerAMG set up from a HypreParMatrix after the solvers");
+  prm.declare_entry ("Verify convergence monitor", "false", Patterns::Bool(),
+                     "Solve with BoomerAMG under a convergence monitor after the solvers and check the residual history");
+  prm.declare_entry ("Max iterations", "3000", Patterns::Integer(1), "Maximum number of iterations");
+  prm.declare_entry ("Tolerance", "1e-10", Patterns::Double(0.0), "Convergence tolerance");
+  prm.declare_entry ("ML tolerance", "1e-12", Patterns::Double(0.0), "Convergence tolerance of the MLPCG solver");
+  prm.declare_entry ("BoomerAMG overrides", "", Patterns::Anything(),
+                     "BoomerAMG parameters in the form name = value; name = value, e.g. relax_type = 6; strength_tolC = 0.5");
+  prm.leave_subsection ();
+
+  prm.enter_subsection ("Parallel");
+  prm.declare_entry ("Threads per process", "1", Patterns::Integer(0),
+                     "Number of threads of the cell assembly on each MPI process, 0 uses all cores");
+  prm.leave_subsection ();
+
+  prm.enter_subsection ("Output");
+  prm.declare_entry ("Scaling mode", "none", Patterns::Selection("none|weak|strong"), "Run a scaling study");
+  prm.declare_entry ("Write solution", "true", Patterns::Bool(), "Write the solution in vtu format");
+  prm.leave_subsection ();
+}
+
+void DiffusionParameters::parse_parameters (ParameterHandler &prm)
+{
+  prm.enter_subsection ("Mesh");
+  dimension = prm.get_integer ("Dimension");
+  n_refinements = prm.get_integer ("Refinements");
+  renumbering = prm.get ("Renumbering");
+  prm.leave_subsection ();
+
+  prm.enter_subsection ("Coefficient");
+  banded_coefficient = prm.get_bool ("Banded");
+  outside_bands_coefficient = prm.get_double ("Outside bands");
+  inside_bands_coefficient = prm.get_double ("Inside bands");
+  prm.leave_subsection ();
+
+  prm.enter_subsection ("Solver");
+  solvers = Utilities::split_string_list (prm.get ("Solvers"));
+  verify_batched_native_solve = prm.get_bool ("Verify batched native solve");
+  verify_convergence_monitor = prm.get_bool ("Verify convergence monitor");
+  max_iterations = prm.get_integer ("Max iterations");
+  tolerance = prm.get_double ("Tolerance");
+  ml_tolerance = prm.get_double ("ML tolerance");
+  boomeramg_overrides = prm.get ("BoomerAMG overrides");
+  prm.leave_subsection ();
+
+  prm.enter_subsection ("Parallel");
+  n_threads = prm.get_integer ("Threads per process");
+  prm.leave_subsection ();
+
+  prm.enter_subsection ("Output");
+  scaling_mode = BoomerAMGDrivers::ScalingStudy::parse_mode (prm.get ("Scaling mode"));
+  write_solution = prm.get_bool ("Write solution");
+  prm.leave_subsection ();
+
+  AssertThrow (!solvers.empty(), ExcMessage ("At least one solver must be selected."));
+}
+//
 //
 template <int dim>
 class DiffusionSolverTest
@@ -116,15 +223,36 @@ class DiffusionSolverTest
 public:
   enum solver_options {CG,JPCG,ICPCG,MLPCG,PCG,Classic_AMG,AIR_AMG};
   enum diffusion_coef_typ {CONST_DIFF, VARRYING_DIFF};
-  DiffusionSolverTest (diffusion_coef_typ diff_coeff_selection);
+  DiffusionSolverTest (const DiffusionParameters &parameters);
   ~DiffusionSolverTest ();
   void run ();
 private:
+  static solver_options parse_solver (const std::string &name);
+  void run_scaling_study ();
   void setup_system ();
+  struct AssemblyScratchData
+  {
+    AssemblyScratchData (const FiniteElement<dim> &fe);
+    AssemblyScratchData (const AssemblyScratchData &scratch_data);
+    FEValues<dim> fe_values;
+  };
+  struct AssemblyCopyData
+  {
+    FullMatrix<double>                   cell_matrix;
+    Vector<double>                       cell_rhs;
+    std::vector<types::global_dof_index> local_dof_indices;
+  };
   void assemble_system ();
+  void local_assemble_system (const typename DoFHandler<dim>::active_cell_iterator &cell,
+                              AssemblyScratchData &scratch_data,
+                              AssemblyCopyData &copy_data);
+  void copy_local_to_global (const AssemblyCopyData &copy_data);
   void solve (solver_options solver_selection);
+  void verify_batched_native_solve ();
+  void verify_convergence_monitor ();
   void refine_grid ();
   void output_results (const unsigned int cycle) const;
+  const DiffusionParameters                 parameters;
   MPI_Comm                                  mpi_communicator;
   parallel::distributed::Triangulation<dim> triangulation;
   DoFHandler<dim>                           dof_handler;
@@ -138,10 +266,13 @@ private:
   ConditionalOStream                        pcout;
   TimerOutput                               computing_timer;
   diffusion_coef_typ diff_coeff_selection;
+  BoomerAMGDrivers::ScalingStudy            scaling_study;
+  double                                    amg_setup_time;
 };
 template <int dim>
-DiffusionSolverTest<dim>::DiffusionSolverTest (diffusion_coef_typ diff_coeff_selection)
+DiffusionSolverTest<dim>::DiffusionSolverTest (const DiffusionParameters &parameters)
   :
+  parameters (parameters),
   mpi_communicator (MPI_COMM_WORLD),
   triangulation (mpi_communicator,
                  typename Triangulation<dim>::MeshSmoothing
@@ -156,7 +287,9 @@ DiffusionSolverTest<dim>::DiffusionSolverTest (diffusion_coef_typ diff_coeff_sel
                    pcout,
                    TimerOutput::summary,
                    TimerOutput::wall_times),
-  diff_coeff_selection(diff_coeff_selection)
+  diff_coeff_selection(parameters.banded_coefficient ? VARRYING_DIFF : CONST_DIFF),
+  scaling_study("diffusion_amg_preconditioner", parameters.scaling_mode, parameters.n_refinements, dim, mpi_communicator),
+  amg_setup_time(0.0)
 {}
 template <int dim>
 DiffusionSolverTest<dim>::~DiffusionSolverTest ()
@@ -164,10 +297,28 @@ DiffusionSolverTest<dim>::~DiffusionSolverTest ()
   dof_handler.clear ();
 }
 template <int dim>
+typename DiffusionSolverTest<dim>::solver_options DiffusionSolverTest<dim>::parse_solver (const std::string &name)
+{
+  if (name == "CG")
+    return CG;
+  else if (name == "ICPCG")
+    return ICPCG;
+  else if (name == "PCG")
+    return PCG;
+  else if (name == "BoomerAMG")
+    return Classic_AMG;
+  else if (name == "MLPCG")
+    return MLPCG;
+
+  AssertThrow (false, ExcMessage ("Unknown solver " + name));
+  return CG;
+}
+template <int dim>
 void DiffusionSolverTest<dim>::setup_system ()
 {
   TimerOutput::Scope t(computing_timer, "setup");
   dof_handler.distribute_dofs (fe);
+  BoomerAMGDrivers::renumber_dofs (dof_handler, parameters.renumbering);
   locally_owned_dofs = dof_handler.locally_owned_dofs ();
   DoFTools::extract_locally_relevant_dofs (dof_handler,
                                            locally_relevant_dofs);
@@ -193,70 +344,98 @@ void DiffusionSolverTest<dim>::setup_system ()
                         locally_owned_dofs,
                         dsp,
                         mpi_communicator);
+  const BoomerAMGDrivers::BandwidthStatistics bandwidth_statistics =
+    BoomerAMGDrivers::BandwidthStatistics::compute (system_matrix);
+  pcout << "Numbering " << parameters.renumbering << ". ";
+  if (pcout.is_active ())
+    bandwidth_statistics.print (pcout.get_stream ());
 }
 template <int dim>
+DiffusionSolverTest<dim>::AssemblyScratchData::AssemblyScratchData (const FiniteElement<dim> &fe)
+  :
+  fe_values (fe, QGauss<dim>(3),
+             update_values    |  update_gradients |
+             update_quadrature_points |
+             update_JxW_values)
+{}
+template <int dim>
+DiffusionSolverTest<dim>::AssemblyScratchData::AssemblyScratchData (const AssemblyScratchData &scratch_data)
+  :
+  fe_values (scratch_data.fe_values.get_fe(),
+             scratch_data.fe_values.get_quadrature(),
+             scratch_data.fe_values.get_update_flags())
+{}
+//
+// The locally owned cells are distributed over the threads of the process by WorkStream
+//
+template <int dim>
 void DiffusionSolverTest<dim>::assemble_system ()
 {
   TimerOutput::Scope t(computing_timer, "assembly");
-  const QGauss<dim>  quadrature_formula(3);
-  FEValues<dim> fe_values (fe, quadrature_formula,
-                           update_values    |  update_gradients |
-                           update_quadrature_points |
-                           update_JxW_values);
-  const unsigned int   dofs_per_cell = fe.dofs_per_cell;
-  const unsigned int   n_q_points    = quadrature_formula.size();
-  FullMatrix<double>   cell_matrix (dofs_per_cell, dofs_per_cell);
-  Vector<double>       cell_rhs (dofs_per_cell);
-  std::vector<types::global_dof_index> local_dof_indices (dofs_per_cell);
-  typename DoFHandler<dim>::active_cell_iterator
-  cell = dof_handler.begin_active(),
-  endc = dof_handler.end();
-  for (; cell!=endc; ++cell)
-    if (cell->is_locally_owned())
-      {
-
-    	double D = 0.0;
-
-    	if (diff_coeff_selection == CONST_DIFF){
-    		D=1.0;
-    	} else{
-    		D = banded_diff_coef<dim>(cell);
-    	}
-
-        cell_matrix = 0;
-        cell_rhs = 0;
-        fe_values.reinit (cell);
-        for (unsigned int q_point=0; q_point<n_q_points; ++q_point)
-          {
-            const double
-            rhs_value = 1.0;
-			/*
-              = (fe_values.quadrature_point(q_point)[1]
-                 >
-                 0.5+0.25*std::sin(4.0 * numbers::PI *
-                                   fe_values.quadrature_point(q_point)[0])
-                 ? 1 : -1); */
-            for (unsigned int i=0; i<dofs_per_cell; ++i)
-              {
-                for (unsigned int j=0; j<dofs_per_cell; ++j)
-                  cell_matrix(i,j) += D*(fe_values.shape_grad(i,q_point) *
-                                       fe_values.shape_grad(j,q_point) *
-                                       fe_values.JxW(q_point));
-                cell_rhs(i) += (rhs_value *
-                                fe_values.shape_value(i,q_point) *
-                                fe_values.JxW(q_point));
-              }
-          }
-        cell->get_dof_indices (local_dof_indices);
-        constraints.distribute_local_to_global (cell_matrix,
-                                                cell_rhs,
-                                                local_dof_indices,
-                                                system_matrix,
-                                                system_rhs);
-      }
+  typedef FilteredIterator<typename DoFHandler<dim>::active_cell_iterator> CellFilter;
+  WorkStream::run (CellFilter (IteratorFilters::LocallyOwnedCell(), dof_handler.begin_active()),
+                   CellFilter (IteratorFilters::LocallyOwnedCell(), dof_handler.end()),
+                   *this,
+                   &DiffusionSolverTest<dim>::local_assemble_system,
+                   &DiffusionSolverTest<dim>::copy_local_to_global,
+                   AssemblyScratchData (fe),
+                   AssemblyCopyData ());
   system_matrix.compress (VectorOperation::add);
   system_rhs.compress (VectorOperation::add);
 }
+template <int dim>
+void DiffusionSolverTest<dim>::local_assemble_system (const typename DoFHandler<dim>::active_cell_iterator &cell,
+                                                      AssemblyScratchData &scratch_data,
+                                                      AssemblyCopyData &copy_data)
+{
+  FEValues<dim> &fe_values = scratch_data.fe_values;
+  const unsigned int   dofs_per_cell = fe.dofs_per_cell;
+  const unsigned int   n_q_points    = fe_values.n_quadrature_points;
+  FullMatrix<double>   &cell_matrix = copy_data.cell_matrix;
+  Vector<double>       &cell_rhs = copy_data.cell_rhs;
+  cell_matrix.reinit (dofs_per_cell, dofs_per_cell);
+  cell_rhs.reinit (dofs_per_cell);
+  copy_data.local_dof_indices.resize (dofs_per_cell);
+
+  double D = 0.0;
+
+  if (diff_coeff_selection == CONST_DIFF){
+	  D=1.0;
+  } else{
+	  typename DoFHandler<dim>::active_cell_iterator active_cell = cell;
+	  D = banded_diff_coef<dim>(active_cell, parameters.outside_bands_coefficient, parameters.inside_bands_coefficient);
+  }
+
+  fe_values.reinit (cell);
+  for (unsigned int q_point=0; q_point<n_q_points; ++q_point)
+    {
+      const double
+      rhs_value = 1.0;
+      for (unsigned int i=0; i<dofs_per_cell; ++i)
+        {
+          for (unsigned int j=0; j<dofs_per_cell; ++j)
+            cell_matrix(i,j) += D*(fe_values.shape_grad(i,q_point) *
+                                 fe_values.shape_grad(j,q_point) *
+                                 fe_values.JxW(q_point));
+          cell_rhs(i) += (rhs_value *
+                          fe_values.shape_value(i,q_point) *
+                          fe_values.JxW(q_point));
+        }
+    }
+  cell->get_dof_indices (copy_data.local_dof_indices);
+}
+//
+// Writing to the global matrix and right hand side is serialized by WorkStream
+//
+template <int dim>
+void DiffusionSolverTest<dim>::copy_local_to_global (const AssemblyCopyData &copy_data)
+{
+  constraints.distribute_local_to_global (copy_data.cell_matrix,
+                                          copy_data.cell_rhs,
+                                          copy_data.local_dof_indices,
+                                          system_matrix,
+                                          system_rhs);
+}
 
 template <int dim>
 void DiffusionSolverTest<dim>::solve (solver_options solver_selection)
@@ -280,26 +459,28 @@ void DiffusionSolverTest<dim>::solve (solver_options solver_selection)
 	case PCG:
 	{
 
-		TrilinosWrappers::BoomerAMGParameters AMG_parameters(TrilinosWrappers::BoomerAMGParameters::CLASSICAL_AMG, Hypre_Chooser::Preconditioner);
-		TrilinosWrappers::ifpackSolverParameters Solver_params(Hypre_Solver::PCG);
+		TrilinosWrappers::BoomerAMGParameters AMG_parameters(TrilinosWrappers::BoomerAMGParameters::CLASSICAL_AMG);
+		AMG_parameters.set_parameter_values(parameters.boomeramg_overrides);
+		TrilinosWrappers::ifpackSolverParameters Solver_params(parameters.max_iterations, parameters.tolerance, Hypre_Solver::PCG);
 
-		typedef TrilinosWrappers::ifpackSolverParameters::parameter_data parameter_data;
 		/**
-		 * deomonstrating how to add parameters
+		 * deomonstrating how to change parameters
 		 */
-		Solver_params.add_parameter("pcg_convergence_tol", parameter_data(1.e-10,&HYPRE_ParCSRPCGSetTol) );
-		Solver_params.add_parameter("pcg_max_itter", parameter_data(3000,&HYPRE_ParCSRPCGSetMaxIter) );
-		Solver_params.add_parameter("pcg_print_level", parameter_data(3,&HYPRE_ParCSRPCGSetPrintLevel) );
+		Solver_params.set_parameter_value("pcg_print_level", 3);
 
 		TrilinosWrappers::BoomerAMG_PreconditionedSolver AMG_solver(AMG_parameters,Solver_params);
 
-		AMG_solver.solve(system_matrix, system_rhs, completely_distributed_solution);
+		AMG_solver.initialize(system_matrix);
+		AMG_solver.solve(completely_distributed_solution, system_rhs);
+
+		const auto AMG_statistics = AMG_solver.get_statistics();
+		amg_setup_time = AMG_statistics.parameter_time + AMG_statistics.conversion_time + AMG_statistics.setup_time;
 		break;
 	}
 	case CG:
 	{
 
-		dealii::SolverControl solver_control(3000,1e-10);
+		dealii::SolverControl solver_control(parameters.max_iterations, parameters.tolerance);
 		TrilinosWrappers::SolverCG::AdditionalData additional_data(true);
 		TrilinosWrappers::SolverCG solver(solver_control, additional_data);
 
@@ -310,7 +491,7 @@ void DiffusionSolverTest<dim>::solve (solver_options solver_selection)
 	case ICPCG:
 	{
 
-		dealii::SolverControl solver_control(3000,1e-10);
+		dealii::SolverControl solver_control(parameters.max_iterations, parameters.tolerance);
 		TrilinosWrappers::SolverCG::AdditionalData additional_data(true);
 		TrilinosWrappers::SolverCG solver(solver_control, additional_data);
 
@@ -324,18 +505,23 @@ void DiffusionSolverTest<dim>::solve (solver_options solver_selection)
 	}
 	case Classic_AMG:
 	{
-	    TrilinosWrappers::BoomerAMGParameters AMG_parameters(TrilinosWrappers::BoomerAMGParameters::CLASSICAL_AMG, Hypre_Chooser::Solver);
+	    TrilinosWrappers::BoomerAMGParameters AMG_parameters(parameters.max_iterations, parameters.tolerance, TrilinosWrappers::BoomerAMGParameters::CLASSICAL_AMG);
+	    AMG_parameters.set_parameter_values(parameters.boomeramg_overrides);
 
 		TrilinosWrappers::SolverBoomerAMG AMG_solver(AMG_parameters);
 
-		AMG_solver.solve(system_matrix, system_rhs, completely_distributed_solution);
+		AMG_solver.initialize(system_matrix);
+		AMG_solver.solve(completely_distributed_solution, system_rhs);
+
+		const auto AMG_statistics = AMG_solver.get_statistics();
+		amg_setup_time = AMG_statistics.parameter_time + AMG_statistics.conversion_time + AMG_statistics.setup_time;
 
 		break;
 	}
 
 	case MLPCG:
 	{
-		SolverControl solver_control (3000, 1e-12);
+		SolverControl solver_control (parameters.max_iterations, parameters.ml_tolerance);
 		TrilinosWrappers::SolverCG::AdditionalData additional_data(true);
 		LA::SolverCG solver(solver_control,additional_data);
 
@@ -353,6 +539,121 @@ void DiffusionSolverTest<dim>::solve (solver_options solver_selection)
 
 }
 
+/**
+ * Verification of the batched solves of SolverBoomerAMG for a setup from a HypreParMatrix. The assembled system is copied
+ * into a HypreParMatrix and solved for two right hand sides, system_rhs and A*1, once through the vector overload and once
+ * through the Epetra_MultiVector overload. The check passes if every true relative residual is below 10 times the tolerance
+ * and both overloads give the same solutions.
+ */
+template <int dim>
+void DiffusionSolverTest<dim>::verify_batched_native_solve ()
+{
+  TimerOutput::Scope t(computing_timer, "verify batched native solve");
+
+  const double tolerance = parameters.tolerance;
+
+  DynamicSparsityPattern dsp (locally_owned_dofs);
+  for (const auto row : locally_owned_dofs)
+    for (auto entry = system_matrix.begin (row); entry != system_matrix.end (row); ++entry)
+      dsp.add (row, entry->column ());
+
+  TrilinosWrappers::HypreParMatrix hypre_matrix;
+  hypre_matrix.reinit (locally_owned_dofs, dsp, mpi_communicator);
+  for (const auto row : locally_owned_dofs)
+    for (auto entry = system_matrix.begin (row); entry != system_matrix.end (row); ++entry)
+      hypre_matrix.add (row, entry->column (), entry->value ());
+  hypre_matrix.compress (VectorOperation::add);
+
+  LA::MPI::Vector ones (locally_owned_dofs, mpi_communicator);
+  ones = 1.0;
+
+  std::vector<LA::MPI::Vector> rhs (2, system_rhs);
+  system_matrix.vmult (rhs[1], ones);
+
+  std::vector<LA::MPI::Vector> vector_solutions (2, LA::MPI::Vector (locally_owned_dofs, mpi_communicator));
+
+  TrilinosWrappers::BoomerAMGParameters AMG_parameters(parameters.max_iterations, tolerance, TrilinosWrappers::BoomerAMGParameters::CLASSICAL_AMG);
+  AMG_parameters.set_parameter_values(parameters.boomeramg_overrides);
+  AMG_parameters.set_parameter_value("hypre_print_level", 0);
+
+  TrilinosWrappers::SolverBoomerAMG AMG_solver(AMG_parameters);
+  AMG_solver.initialize (hypre_matrix);
+  AMG_solver.solve (vector_solutions, rhs);
+
+  Epetra_MultiVector B (system_rhs.trilinos_vector().Map(), 2);
+  Epetra_MultiVector X (system_rhs.trilinos_vector().Map(), 2, true);
+  for (unsigned int i=0; i<rhs.size(); ++i)
+    B(i)->Update (1.0, *rhs[i].trilinos_vector()(0), 0.0);
+  AMG_solver.solve (X, B);
+
+  LA::MPI::Vector residual (locally_owned_dofs, mpi_communicator);
+  LA::MPI::Vector multivector_solution (locally_owned_dofs, mpi_communicator);
+
+  bool passed = true;
+  for (unsigned int i=0; i<rhs.size(); ++i)
+    {
+      const double relative_residual = system_matrix.residual (residual, vector_solutions[i], rhs[i])/rhs[i].l2_norm ();
+
+      multivector_solution.trilinos_vector()(0)->Update (1.0, *X(i), 0.0);
+      multivector_solution -= vector_solutions[i];
+      const double solution_difference = multivector_solution.l2_norm ()/vector_solutions[i].l2_norm ();
+
+      pcout << "right hand side " << i << ": relative residual " << relative_residual
+            << ", difference of the overloads " << solution_difference << std::endl;
+
+      passed = passed && (relative_residual <= 10.0*tolerance) && (solution_difference <= 10.0*tolerance);
+    }
+
+  pcout << "Batched native solve verification " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+/**
+ * Verification of the convergence monitor of the solver wrappers. The system is solved with BoomerAMG as the solver, two
+ * cycles per check. The check passes if the relative residual decreases from every check to the next, the tolerance is
+ * reached and the monitor reports the same final residual as the true residual of the solution.
+ */
+template <int dim>
+void DiffusionSolverTest<dim>::verify_convergence_monitor ()
+{
+  TimerOutput::Scope t(computing_timer, "verify convergence monitor");
+
+  const double tolerance = parameters.tolerance;
+
+  LA::MPI::Vector solution (locally_owned_dofs, mpi_communicator);
+  LA::MPI::Vector residual (locally_owned_dofs, mpi_communicator);
+
+  TrilinosWrappers::BoomerAMGParameters AMG_parameters(parameters.max_iterations, tolerance, TrilinosWrappers::BoomerAMGParameters::CLASSICAL_AMG);
+  AMG_parameters.set_parameter_values(parameters.boomeramg_overrides);
+  AMG_parameters.set_parameter_value("hypre_print_level", 0);
+
+  TrilinosWrappers::SolverBoomerAMG AMG_solver(AMG_parameters);
+  AMG_solver.set_convergence_monitor (TrilinosWrappers::ifpackHypreSolverBase::ConvergenceMonitor(
+      [](const unsigned int, const std::vector<double> &)
+      {
+        return TrilinosWrappers::ifpackHypreSolverBase::continue_iteration;
+      },
+      parameters.max_iterations, tolerance, 2));
+
+  AMG_solver.initialize (system_matrix);
+  AMG_solver.solve (solution, system_rhs);
+
+  const std::vector<double> &history = AMG_solver.get_convergence_history ();
+
+  bool decreasing = (history.size () > 1);
+  for (unsigned int i=1; i<history.size (); ++i)
+    {
+      pcout << "check " << i << ": relative residual " << history[i] << std::endl;
+      decreasing = decreasing && (history[i] < history[i-1]);
+    }
+
+  const double true_residual = system_matrix.residual (residual, solution, system_rhs)/system_rhs.l2_norm ();
+
+  const bool passed = decreasing && (history.back () <= tolerance) &&
+                      (std::abs (true_residual - history.back ()) <= 1.e-3*history.back () + 1.e-14);
+
+  pcout << "Convergence monitor verification " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
 template <int dim>
 void DiffusionSolverTest<dim>::refine_grid ()
 {
@@ -385,7 +686,7 @@ void DiffusionSolverTest<dim>::refine_grid ()
 
   triangulation.refine_global(1);
   //8 gets about 1e6 cells, 6 solvers all competitive
-  for(int i=0;i<7;++i){
+  for(unsigned int i=1;i<scaling_study.n_refinements();++i){
   	dummy_error.reinit(triangulation.n_active_cells());
   	dummy_error = 1.0;
   	parallel::distributed::GridRefinement::refine_and_coarsen_fixed_number(triangulation,dummy_error,1.0,0.0);
@@ -439,49 +740,80 @@ void DiffusionSolverTest<dim>::run ()
           << Utilities::MPI::n_mpi_processes(mpi_communicator)
           << " MPI rank(s)..." << std::endl;
 
+  if (scaling_study.active ())
+    {
+      run_scaling_study ();
+      return;
+    }
+
   refine_grid ();
 
-  pcout << "Solver CG"<< std::endl;
-  setup_system ();
-  assemble_system ();
-  solve (DiffusionSolverTest<2>::CG);
-  computing_timer.print_summary ();
-  computing_timer.reset ();
-  pcout << std::endl;
+  for (const auto &solver_name : parameters.solvers)
+    {
+      pcout << "Solver " << solver_name << std::endl;
+      setup_system ();
+      assemble_system ();
+      solve (parse_solver (solver_name));
+      computing_timer.print_summary ();
+      computing_timer.reset ();
+      pcout << std::endl;
+    }
 
-  pcout << "Solver ICPCG"<< std::endl;
-  setup_system ();
-  assemble_system ();
-  solve (DiffusionSolverTest<2>::ICPCG);
-  computing_timer.print_summary ();
-  computing_timer.reset ();
-  pcout << std::endl;
+  if (parameters.verify_batched_native_solve)
+    {
+      pcout << "Batched native solve verification"<< std::endl;
+      setup_system ();
+      assemble_system ();
+      verify_batched_native_solve ();
+      computing_timer.print_summary ();
+      computing_timer.reset ();
+      pcout << std::endl;
+    }
 
-  pcout << "Solver PCG"<< std::endl;
-  setup_system ();
-  assemble_system ();
-  solve (DiffusionSolverTest<2>::PCG);
-  computing_timer.print_summary ();
-  computing_timer.reset ();
-  pcout << std::endl;
+  if (parameters.verify_convergence_monitor)
+    {
+      pcout << "Convergence monitor verification"<< std::endl;
+      setup_system ();
+      assemble_system ();
+      verify_convergence_monitor ();
+      computing_timer.print_summary ();
+      computing_timer.reset ();
+      pcout << std::endl;
+    }
 
-  pcout << "BoomerAMG solver"<< std::endl;
-  setup_system ();
-  assemble_system ();
-  solve (DiffusionSolverTest<2>::Classic_AMG);
-  computing_timer.print_summary ();
-  computing_timer.reset ();
-  pcout << std::endl;
+  if (parameters.write_solution)
+    output_results (1);
+}
 
-  pcout << "MLPCG"<< std::endl;
+/**
+ * A single solve with the first selected solver on a mesh refined according to the scaling study. The phase times are
+ * taken from the timer sections, the AMG setup is reported separately from the iterations of the solve.
+ */
+template <int dim>
+void DiffusionSolverTest<dim>::run_scaling_study ()
+{
+  refine_grid ();
   setup_system ();
   assemble_system ();
-  solve (DiffusionSolverTest<2>::MLPCG);
+  solve (parse_solver (parameters.solvers.front()));
+  if (parameters.write_solution)
+    {
+      TimerOutput::Scope t(computing_timer, "output");
+      output_results (1);
+    }
+
+  std::map<std::string, double> timings = computing_timer.get_summary_data (TimerOutput::total_wall_time);
+
+  scaling_study.set_problem_size (dof_handler.n_dofs());
+  scaling_study.add_phase_time ("setup", timings["refine"] + timings["setup"]);
+  scaling_study.add_phase_time ("assembly", timings["assembly"]);
+  scaling_study.add_phase_time ("AMG setup", amg_setup_time);
+  scaling_study.add_phase_time ("solve", timings["solve"] - amg_setup_time);
+  scaling_study.add_phase_time ("output", timings["output"]);
+  scaling_study.report ("scaling_results.csv", std::cout);
+
   computing_timer.print_summary ();
   computing_timer.reset ();
-  pcout << std::endl;
-
-  output_results (1);
 }
 
 
@@ -490,8 +822,29 @@ int main(int argc, char *argv[])
   try
     {
       Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
-      DiffusionSolverTest<2> laplace_problem_2d(DiffusionSolverTest<2>::VARRYING_DIFF);
-      laplace_problem_2d.run ();
+      /**
+       * The configuration is read from an optional parameter file and --set options, see --help
+       */
+      ParameterHandler prm;
+      DiffusionParameters::declare_parameters (prm);
+      if (!BoomerAMGDrivers::parse_command_line (prm, argc, argv))
+        return 0;
+
+      DiffusionParameters parameters;
+      parameters.parse_parameters (prm);
+
+      MultithreadInfo::set_thread_limit (parameters.n_threads == 0 ? numbers::invalid_unsigned_int : parameters.n_threads);
+
+      if (parameters.dimension == 2)
+        {
+          DiffusionSolverTest<2> laplace_problem_2d(parameters);
+          laplace_problem_2d.run ();
+        }
+      else
+        {
+          DiffusionSolverTest<3> laplace_problem_3d(parameters);
+          laplace_problem_3d.run ();
+        }
     }
   catch (std::exception &exc)
     {
@@ -30,9 +30,12 @@
 
 #include <deal.II/base/utilities.h>
 #include <deal.II/base/timer.h>
+#include <deal.II/base/multithread_info.h>
+#include <deal.II/base/work_stream.h>
 #include <deal.II/base/utilities.h>
 #include <deal.II/base/conditional_ostream.h>
 #include <deal.II/base/index_set.h>
+#include <deal.II/base/parameter_handler.h>
 
 #include <deal.II/base/quadrature_lib.h>
 #include <deal.II/base/function.h>
@@ -41,10 +44,12 @@
 #include <deal.II/grid/grid_out.h>
 #include <deal.II/grid/tria_accessor.h>
 #include <deal.II/grid/tria_iterator.h>
+#include <deal.II/grid/filtered_iterator.h>
 #include <deal.II/fe/fe_values.h>
 #include <deal.II/dofs/dof_handler.h>
 #include <deal.II/dofs/dof_accessor.h>
 #include <deal.II/dofs/dof_tools.h>
+#include <deal.II/dofs/dof_renumbering.h>
 #include <deal.II/numerics/data_out.h>
 #include <deal.II/fe/mapping_q1.h>
 #include <deal.II/fe/fe_dgq.h>
@@ -58,12 +63,21 @@
 #include <deal.II/meshworker/loop.h>
 
 #include <iostream>
+#include <iomanip>
 #include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
 //
 //
 ///////////////////////////////////////////////
 //
 #include "BoomerAMG_solver.h"
+#include "BoomerAMG_autotuner.h"
+#include "BoomerAMG_parameter_cache.h"
+#include "scaling_study.h"
+#include "driver_parameters.h"
+#include "cell_block_inverse.h"
 
 
 namespace LA =  dealii::LinearAlgebraTrilinos;
@@ -115,27 +129,147 @@ Tensor<1, dim> beta(const Point<dim> &p)
 
 
 
+/**
+ * Run time configuration, read from a parameter file and the command line
+ */
+struct AdvectionParameters
+{
+  static void declare_parameters(ParameterHandler &prm);
+  void parse_parameters(ParameterHandler &prm);
+
+  unsigned int dimension;
+  unsigned int n_subdivisions;
+  unsigned int n_refinements;
+  unsigned int n_cycles;
+  bool downwind_renumbering;
+  bool block_scaling;
+  bool block_scaled_assembly;
+  std::string solver;
+  unsigned int max_iterations;
+  double tolerance;
+  unsigned int gmres_restart;
+  std::string boomeramg_overrides;
+  std::string autotune;
+  std::string autotune_file;
+  std::string parameter_cache;
+  bool verify_reduced_memory_hierarchy;
+  unsigned int n_threads;
+  BoomerAMGDrivers::ScalingStudy::scaling_mode scaling_mode;
+  bool write_solution;
+};
+
+void AdvectionParameters::declare_parameters(ParameterHandler &prm)
+{
+  prm.enter_subsection("Mesh");
+  prm.declare_entry("Dimension", "3", Patterns::Integer(2,3), "Space dimension");
+  prm.declare_entry("Subdivisions", "4", Patterns::Integer(1), "Number of subdivisions of the unit cube in each direction");
+  prm.declare_entry("Refinements", "2", Patterns::Integer(0),
+                    "Number of global refinements of the initial mesh, the base for a scaling study");
+  prm.declare_entry("Cycles", "4", Patterns::Integer(1), "Number of adaptive refinement cycles");
+  prm.declare_entry("Renumbering", "none", Patterns::Selection("none|downwind"),
+                    "Numbering of the cells, downwind numbers every cell after its upwind neighbors");
+  prm.leave_subsection();
+
+  prm.enter_subsection("Solver");
+  prm.declare_entry("Block scaling", "true", Patterns::Bool(),
+                    "Scale the system by the inverse of its cell diagonal blocks before the solve");
+  prm.declare_entry("Scale during assembly", "false", Patterns::Bool(),
+                    "Apply the block scaling cell by cell during the assembly instead of in a pass over the assembled matrix");
+  prm.declare_entry("Solver", "AIR", Patterns::Selection("AIR|GMRES-AIR"), "Linear solver");
+  prm.declare_entry("Max iterations", "200", Patterns::Integer(1), "Maximum number of iterations");
+  prm.declare_entry("Tolerance", "1e-8", Patterns::Double(0.0), "Relative tolerance");
+  prm.declare_entry("GMRES restart", "50", Patterns::Integer(1), "Krylov space dimension of GMRES-AIR");
+  prm.declare_entry("BoomerAMG overrides", "", Patterns::Anything(),
+                    "BoomerAMG parameters in the form name = value; name = value, e.g. distance_R = 2; strength_tolC = 0.5");
+  prm.declare_entry("Autotune", "none", Patterns::Selection("none|tune|load"),
+                    "Choice of the AIR parameters: none uses distance_R = 1 and the overrides, tune ranks trial solves on the "
+                    "system of the first cycle and saves the best candidate to the autotune file, load reads that file");
+  prm.declare_entry("Autotune file", "air_parameters.txt", Patterns::FileName(),
+                    "File the AIR parameters selected by the autotuning are saved to and loaded from");
+  prm.declare_entry("Parameter cache", "", Patterns::Anything(),
+                    "BoomerAMGParameterCache file the AIR solver looks its parameters up in, the autotuning also stores "
+                    "its best candidate there. No cache is used if empty");
+  prm.declare_entry("Verify reduced memory hierarchy", "false", Patterns::Bool(),
+                    "Compare GMRES-AIR with the full and the reduced hierarchy on the system of the last cycle");
+  prm.leave_subsection();
+
+  prm.enter_subsection("Parallel");
+  prm.declare_entry("Threads per process", "1", Patterns::Integer(0),
+                    "Number of threads of the cell and face assembly on each MPI process, 0 uses all cores");
+  prm.leave_subsection();
+
+  prm.enter_subsection("Output");
+  prm.declare_entry("Scaling mode", "none", Patterns::Selection("none|weak|strong"),
+                    "Run a scaling study, a single cycle on a uniformly refined mesh");
+  prm.declare_entry("Write solution", "true", Patterns::Bool(), "Write the solution of every cycle in vtu format");
+  prm.leave_subsection();
+}
+
+void AdvectionParameters::parse_parameters(ParameterHandler &prm)
+{
+  prm.enter_subsection("Mesh");
+  dimension = prm.get_integer("Dimension");
+  n_subdivisions = prm.get_integer("Subdivisions");
+  n_refinements = prm.get_integer("Refinements");
+  n_cycles = prm.get_integer("Cycles");
+  downwind_renumbering = (prm.get("Renumbering") == "downwind");
+  prm.leave_subsection();
+
+  prm.enter_subsection("Solver");
+  block_scaling = prm.get_bool("Block scaling");
+  block_scaled_assembly = block_scaling && prm.get_bool("Scale during assembly");
+  solver = prm.get("Solver");
+  max_iterations = prm.get_integer("Max iterations");
+  tolerance = prm.get_double("Tolerance");
+  gmres_restart = prm.get_integer("GMRES restart");
+  boomeramg_overrides = prm.get("BoomerAMG overrides");
+  autotune = prm.get("Autotune");
+  autotune_file = prm.get("Autotune file");
+  parameter_cache = prm.get("Parameter cache");
+  verify_reduced_memory_hierarchy = prm.get_bool("Verify reduced memory hierarchy");
+  prm.leave_subsection();
+
+  prm.enter_subsection("Parallel");
+  n_threads = prm.get_integer("Threads per process");
+  prm.leave_subsection();
+
+  prm.enter_subsection("Output");
+  scaling_mode = BoomerAMGDrivers::ScalingStudy::parse_mode(prm.get("Scaling mode"));
+  write_solution = prm.get_bool("Write solution");
+  prm.leave_subsection();
+}
+
+
+
 template <int dim>
 class AdvectionProblem
 {
 public:
-  AdvectionProblem();
+  AdvectionProblem(const AdvectionParameters &parameters);
   void run();
 
 private:
   void precondition(LA::MPI::SparseMatrix & system_matrix, LA::MPI::Vector & right_hand_side);
+  void renumber_downwind();
   void setup_system();
   void assemble_system();
+  void assemble_block_scaled_system();
+  void autotune();
+  void set_AMG_parameters(TrilinosWrappers::BoomerAMGParameters &AMG_parameters) const;
   void solve(LA::MPI::Vector &solution);
+  void verify_reduced_memory_hierarchy();
   void refine_grid();
   void output_results(const unsigned int cycle) const;
 
+  const AdvectionParameters                 parameters;
+
   MPI_Comm                                  mpi_communicator;
 
   const unsigned int n_mpi_processes;
   const unsigned int this_mpi_process;
 
   ConditionalOStream                pcout;
+  TimerOutput                       computing_timer;
 
   parallel::distributed::Triangulation<dim>   triangulation;
   const MappingQ1<dim> mapping;
@@ -148,6 +282,14 @@ private:
   LA::MPI::Vector solution;
   LA::MPI::Vector right_hand_side;
 
+  BoomerAMGDrivers::ScalingStudy scaling_study;
+  double amg_setup_time;
+
+  /**
+   * AIR parameter values selected by autotune(), applied by set_AMG_parameters
+   */
+  std::vector<std::pair<std::string,TrilinosWrappers::ifpackHypreSolverPrecondParameters::param_value_variant>> tuned_values;
+
   using DoFInfo  = MeshWorker::DoFInfo<dim>;
   using CellInfo = MeshWorker::IntegrationInfo<dim>;
 
@@ -157,74 +299,176 @@ private:
                                   DoFInfo & dinfo2,
                                   CellInfo &info1,
                                   CellInfo &info2);
+
+  /**
+   * Per thread data of the block scaled assembly
+   */
+  struct BlockScaledScratchData
+  {
+    BlockScaledScratchData(const Mapping<dim> &mapping, const FiniteElement<dim> &fe, const unsigned int n_points);
+    BlockScaledScratchData(const BlockScaledScratchData &scratch_data);
+
+    FEValues<dim>        fe_values;
+    FEFaceValues<dim>    fe_face_values;
+    FESubfaceValues<dim> fe_subface_values;
+    FEFaceValues<dim>    fe_face_values_neighbor;
+    FESubfaceValues<dim> fe_subface_values_neighbor;
+
+    FullMatrix<double>              cell_block;
+    std::vector<FullMatrix<double>> neighbor_blocks;
+    Vector<double>                  cell_rhs;
+  };
+
+  /**
+   * Block scaled rows of a cell, the columns are the dofs of the cell followed by those of its neighbors
+   */
+  struct BlockScaledCopyData
+  {
+    std::vector<types::global_dof_index> row_indices;
+    std::vector<types::global_dof_index> column_indices;
+    FullMatrix<double>                   rows;
+    Vector<double>                       rhs;
+  };
+
+  void local_assemble_block_scaled_system(const typename DoFHandler<dim>::active_cell_iterator &cell,
+                                          BlockScaledScratchData &scratch_data,
+                                          BlockScaledCopyData &copy_data);
+  void copy_block_scaled_rows(const BlockScaledCopyData &copy_data);
+
+  static void integrate_face_rows(const FEFaceValuesBase<dim> &fe_face_values,
+                                  const FEFaceValuesBase<dim> &fe_face_values_neighbor,
+                                  FullMatrix<double> &cell_block,
+                                  FullMatrix<double> &neighbor_block);
 };
 
 template <int dim>
-AdvectionProblem<dim>::AdvectionProblem()
-  : mpi_communicator (MPI_COMM_WORLD),
+AdvectionProblem<dim>::AdvectionProblem(const AdvectionParameters &parameters)
+  : parameters (parameters),
+	mpi_communicator (MPI_COMM_WORLD),
 	n_mpi_processes (dealii::Utilities::MPI::n_mpi_processes(mpi_communicator)),
 	this_mpi_process (dealii::Utilities::MPI::this_mpi_process(mpi_communicator)),
 	pcout (std::cout,
 	       (this_mpi_process == 0)),
+	computing_timer (mpi_communicator,
+	                 pcout,
+	                 TimerOutput::summary,
+	                 TimerOutput::wall_times),
     triangulation(mpi_communicator,typename Triangulation<dim>::MeshSmoothing
             (Triangulation<dim>::smoothing_on_refinement |
              Triangulation<dim>::smoothing_on_coarsening)),
 	mapping(),
 	fe(1),
-	dof_handler(triangulation)
+	dof_handler(triangulation),
+	scaling_study("simple_advection", parameters.scaling_mode, parameters.n_refinements, dim, mpi_communicator),
+	amg_setup_time(0.0)
 
 {}
 
 template <int dim>
 void AdvectionProblem<dim>::precondition(LA::MPI::SparseMatrix & system_matrix, LA::MPI::Vector & right_hand_side)
 {
-	int i_block_size;
-	if (dim == 2)
-		i_block_size=4;
-	else
-		i_block_size=8;
+	//
+	// the dofs of a cell are numbered consecutively, the diagonal block of a cell is its dofs_per_cell square block
+	//
+	const unsigned int i_block_size = fe.dofs_per_cell;
+
+	TrilinosWrappers::CellBlockInverse block_inverse;
+	block_inverse.initialize(system_matrix, i_block_size);
+	//
+	// the rows are scaled in place, no second matrix is formed
+	//
+	block_inverse.scale_rows(system_matrix);
+	//
+	LA::MPI::Vector rhs_store;
+	rhs_store = right_hand_side;
+	//
+	block_inverse.vmult(right_hand_side,rhs_store);
+}
 
-	dealii::FullMatrix<double> diagonal_block(i_block_size,i_block_size);
+/**
+ * Number the locally owned cells so that every cell comes after its upwind neighbors, which makes the upwind operator
+ * nearly lower block triangular. The cells are sorted topologically along the wind: a cell is upwind of a neighbor if
+ * beta, at the midpoint between their centers, points from the cell to the neighbor. Cells are taken in order of the
+ * number of their upwind neighbors that are not numbered yet, so a cell without remaining upwind neighbors is taken
+ * first. If none is left the flow has a cycle among the remaining cells, which is broken by taking the cell with the
+ * fewest remaining upwind neighbors. Ties are resolved by the original order. Only neighbors owned by this process are
+ * considered, the dofs of a process keep their range.
+ */
+template <int dim>
+void AdvectionProblem<dim>::renumber_downwind()
+{
+	std::vector<typename DoFHandler<dim>::active_cell_iterator> cells;
+	std::map<CellId, unsigned int> cell_index;
 
-	LA::MPI::SparseMatrix preconditioner;
+	for (const auto &cell : dof_handler.active_cell_iterators())
+		if (cell->is_locally_owned()){
+			cell_index[cell->id()] = cells.size();
+			cells.push_back(cell);
+		}
+	//
+	// the downwind neighbors of every cell and the number of upwind neighbors
+	//
+	std::vector<std::vector<unsigned int>> downwind_neighbors(cells.size());
+	std::vector<unsigned int> n_upwind(cells.size(), 0);
 
-	preconditioner.reinit(system_matrix);
+	for (unsigned int c = 0; c < cells.size(); ++c)
+		for (unsigned int face_no = 0; face_no < GeometryInfo<dim>::faces_per_cell; ++face_no){
 
-	preconditioner = 0.0;
+			if (cells[c]->at_boundary(face_no))
+				continue;
 
-	const std::pair<int, int>  local_range = system_matrix.local_range();
+			std::vector<typename DoFHandler<dim>::cell_iterator> neighbors;
+			if (cells[c]->face(face_no)->has_children())
+				for (unsigned int subface_no = 0; subface_no < cells[c]->face(face_no)->n_children(); ++subface_no)
+					neighbors.push_back(cells[c]->neighbor_child_on_subface(face_no, subface_no));
+			else
+				neighbors.push_back(cells[c]->neighbor(face_no));
 
-	const int off_set = local_range.first;
+			for (const auto &neighbor : neighbors){
 
-	for (unsigned int i_block =0; i_block<system_matrix.local_size() ;i_block+=i_block_size){
+				if (!neighbor->is_locally_owned())
+					continue;
 
-		for (unsigned int i = 0; i<i_block_size ; ++i) {
+				const Tensor<1, dim> direction = neighbor->center() - cells[c]->center();
+				const Point<dim> midpoint = cells[c]->center() + 0.5*direction;
 
-			for (unsigned int j = 0; j<i_block_size ; ++j) {
-				diagonal_block[i][j] = system_matrix(i+i_block+off_set , j+i_block+off_set);
+				if (beta(midpoint)*direction > 0){
+					const unsigned int n = cell_index[neighbor->id()];
+					downwind_neighbors[c].push_back(n);
+					++n_upwind[n];
+				}
 			}
 		}
+	//
+	// topological sort, the set holds the cells not numbered yet ordered by their number of remaining upwind neighbors
+	//
+	std::set<std::pair<unsigned int, unsigned int>> remaining;
+	for (unsigned int c = 0; c < cells.size(); ++c)
+		remaining.insert({n_upwind[c], c});
 
-		diagonal_block.gauss_jordan();
+	std::vector<typename DoFHandler<dim>::active_cell_iterator> cell_order;
+	cell_order.reserve(cells.size());
+	unsigned int n_broken_cycles = 0;
 
-		for (unsigned int i = 0; i<i_block_size ; ++i) {
+	while (!remaining.empty()){
 
-			for (unsigned int j = 0; j<i_block_size ; ++j) {
-				preconditioner.set(i+i_block+off_set , j+i_block+off_set ,diagonal_block[i][j]);
-			}
-		}
+		const unsigned int c = remaining.begin()->second;
+		if (remaining.begin()->first > 0)
+			++n_broken_cycles;
+		remaining.erase(remaining.begin());
+
+		cell_order.push_back(cells[c]);
+		n_upwind[c] = 0;
+
+		for (const unsigned int n : downwind_neighbors[c])
+			if (remaining.erase({n_upwind[n], n}) > 0)
+				remaining.insert({--n_upwind[n], n});
 	}
-	//
-	LA::MPI::SparseMatrix store_solution;
-	//
-	store_solution.reinit(system_matrix.trilinos_matrix());
-	//
-	preconditioner.mmult(system_matrix,store_solution);
-	//
-	LA::MPI::Vector rhs_store;
-	rhs_store = right_hand_side;
-	//
-	preconditioner.vmult(right_hand_side,rhs_store);
+
+	DoFRenumbering::cell_wise(dof_handler, cell_order);
+
+	pcout << "Downwind renumbering, cycles broken: "
+	      << Utilities::MPI::sum(n_broken_cycles, mpi_communicator) << std::endl;
 }
 
 template <int dim>
@@ -233,6 +477,9 @@ void AdvectionProblem<dim>::setup_system()
 	//
 	dof_handler.distribute_dofs (fe);
 	//
+	if (parameters.downwind_renumbering)
+		renumber_downwind();
+	//
     const IndexSet locally_owned_dofs = dof_handler.locally_owned_dofs();
     //
     //
@@ -263,6 +510,12 @@ void AdvectionProblem<dim>::setup_system()
 template <int dim>
 void AdvectionProblem<dim>::assemble_system()
 {
+  if (parameters.block_scaled_assembly)
+    {
+      assemble_block_scaled_system();
+      return;
+    }
+
   MeshWorker::IntegrationInfoBox<dim> info_box;
 
   const unsigned int n_gauss_points = dof_handler.get_fe().degree + 1;
@@ -286,6 +539,11 @@ void AdvectionProblem<dim>::assemble_system()
   MeshWorker::LoopControl loop_control;
 
   loop_control.faces_to_ghost = dealii::MeshWorker::LoopControl::both;
+  //
+  // MeshWorker::loop runs the integrators on the threads of the process through WorkStream, each thread works on its
+  // own copy of dof_info and info_box and the assembler writes to the global matrix serially. The integrators only
+  // read shared data, the number of threads is set by Parallel/Threads per process.
+  //
 
   MeshWorker::loop<dim,
                    dim,
@@ -303,6 +561,246 @@ void AdvectionProblem<dim>::assemble_system()
 
 
 
+template <int dim>
+AdvectionProblem<dim>::BlockScaledScratchData::BlockScaledScratchData(const Mapping<dim> &mapping,
+                                                                      const FiniteElement<dim> &fe,
+                                                                      const unsigned int n_points)
+  : fe_values(mapping, fe, QGauss<dim>(n_points),
+              update_quadrature_points | update_values | update_gradients | update_JxW_values),
+    fe_face_values(mapping, fe, QGauss<dim-1>(n_points),
+                   update_quadrature_points | update_values | update_normal_vectors | update_JxW_values),
+    fe_subface_values(mapping, fe, QGauss<dim-1>(n_points),
+                      update_quadrature_points | update_values | update_normal_vectors | update_JxW_values),
+    fe_face_values_neighbor(mapping, fe, QGauss<dim-1>(n_points), update_values),
+    fe_subface_values_neighbor(mapping, fe, QGauss<dim-1>(n_points), update_values)
+{}
+
+template <int dim>
+AdvectionProblem<dim>::BlockScaledScratchData::BlockScaledScratchData(const BlockScaledScratchData &scratch_data)
+  : BlockScaledScratchData(scratch_data.fe_values.get_mapping(),
+                           scratch_data.fe_values.get_fe(),
+                           scratch_data.fe_values.get_fe().degree + 1)
+{}
+
+/**
+ * Assembly of the block scaled system without a pass over the assembled matrix. Every cell integrates its own rows
+ * completely, the faces are visited from both sides, so the diagonal block of the cell is known locally. It is inverted
+ * and the rows and the right hand side of the cell are multiplied by the inverse before they are added to the global
+ * system. The diagonal block of the scaled system is the identity.
+ */
+template <int dim>
+void AdvectionProblem<dim>::assemble_block_scaled_system()
+{
+  typedef FilteredIterator<typename DoFHandler<dim>::active_cell_iterator> CellFilter;
+
+  WorkStream::run(CellFilter(IteratorFilters::LocallyOwnedCell(), dof_handler.begin_active()),
+                  CellFilter(IteratorFilters::LocallyOwnedCell(), dof_handler.end()),
+                  *this,
+                  &AdvectionProblem<dim>::local_assemble_block_scaled_system,
+                  &AdvectionProblem<dim>::copy_block_scaled_rows,
+                  BlockScaledScratchData(mapping, fe, fe.degree + 1),
+                  BlockScaledCopyData());
+
+  system_matrix.compress(VectorOperation::add);
+  right_hand_side.compress(VectorOperation::add);
+}
+
+template <int dim>
+void AdvectionProblem<dim>::local_assemble_block_scaled_system(const typename DoFHandler<dim>::active_cell_iterator &cell,
+                                                               BlockScaledScratchData &scratch_data,
+                                                               BlockScaledCopyData &copy_data)
+{
+  const unsigned int dofs_per_cell = fe.dofs_per_cell;
+
+  FullMatrix<double> &cell_block = scratch_data.cell_block;
+  Vector<double> &    cell_rhs   = scratch_data.cell_rhs;
+
+  cell_block.reinit(dofs_per_cell, dofs_per_cell);
+  cell_rhs.reinit(dofs_per_cell);
+
+  copy_data.row_indices.resize(dofs_per_cell);
+  cell->get_dof_indices(copy_data.row_indices);
+  copy_data.column_indices = copy_data.row_indices;
+
+  std::vector<types::global_dof_index> neighbor_dof_indices(dofs_per_cell);
+  unsigned int n_neighbors = 0;
+
+  auto next_neighbor_block = [&](const typename DoFHandler<dim>::cell_iterator &neighbor) -> FullMatrix<double> & {
+    neighbor->get_dof_indices(neighbor_dof_indices);
+    copy_data.column_indices.insert(copy_data.column_indices.end(), neighbor_dof_indices.begin(), neighbor_dof_indices.end());
+
+    if (scratch_data.neighbor_blocks.size() <= n_neighbors)
+      scratch_data.neighbor_blocks.resize(n_neighbors + 1);
+    scratch_data.neighbor_blocks[n_neighbors].reinit(dofs_per_cell, dofs_per_cell);
+
+    return scratch_data.neighbor_blocks[n_neighbors++];
+  };
+  //
+  // cell term, the same integrand as integrate_cell_term
+  //
+  const FEValues<dim> &fe_values = scratch_data.fe_values;
+  scratch_data.fe_values.reinit(cell);
+
+  for (unsigned int point = 0; point < fe_values.n_quadrature_points; ++point)
+    {
+      const Tensor<1, dim> beta_at_q_point =
+        beta(fe_values.quadrature_point(point));
+
+      for (unsigned int i = 0; i < dofs_per_cell; ++i)
+        for (unsigned int j = 0; j < dofs_per_cell; ++j)
+          cell_block(i, j) += -beta_at_q_point *                //
+                              fe_values.shape_grad(i, point) *  //
+                              fe_values.shape_value(j, point) * //
+                              fe_values.JxW(point);
+    }
+  //
+  // boundary and face terms of the rows of this cell
+  //
+  for (unsigned int face_no = 0; face_no < GeometryInfo<dim>::faces_per_cell; ++face_no)
+    {
+      if (cell->at_boundary(face_no))
+        {
+          scratch_data.fe_face_values.reinit(cell, face_no);
+
+          const FEFaceValues<dim> &fe_face_values = scratch_data.fe_face_values;
+
+          std::vector<double> g(fe_face_values.n_quadrature_points);
+
+          static BoundaryValues<dim> boundary_function;
+          boundary_function.value_list(fe_face_values.get_quadrature_points(), g);
+
+          for (unsigned int point = 0; point < fe_face_values.n_quadrature_points;
+               ++point)
+            {
+              const double beta_dot_n =
+                beta(fe_face_values.quadrature_point(point)) * fe_face_values.normal_vector(point);
+              if (beta_dot_n > 0)
+                for (unsigned int i = 0; i < dofs_per_cell; ++i)
+                  for (unsigned int j = 0; j < dofs_per_cell; ++j)
+                    cell_block(i, j) += beta_dot_n *                           //
+                                        fe_face_values.shape_value(j, point) * //
+                                        fe_face_values.shape_value(i, point) * //
+                                        fe_face_values.JxW(point);
+              else
+                for (unsigned int i = 0; i < dofs_per_cell; ++i)
+                  cell_rhs(i) += -beta_dot_n *                          //
+                                 g[point] *                             //
+                                 fe_face_values.shape_value(i, point) * //
+                                 fe_face_values.JxW(point);
+            }
+        }
+      else if (cell->face(face_no)->has_children())
+        {
+          const unsigned int neighbor_face_no = cell->neighbor_face_no(face_no);
+
+          for (unsigned int subface_no = 0; subface_no < cell->face(face_no)->n_children(); ++subface_no)
+            {
+              const typename DoFHandler<dim>::cell_iterator neighbor =
+                cell->neighbor_child_on_subface(face_no, subface_no);
+
+              scratch_data.fe_subface_values.reinit(cell, face_no, subface_no);
+              scratch_data.fe_face_values_neighbor.reinit(neighbor, neighbor_face_no);
+
+              integrate_face_rows(scratch_data.fe_subface_values,
+                                  scratch_data.fe_face_values_neighbor,
+                                  cell_block,
+                                  next_neighbor_block(neighbor));
+            }
+        }
+      else if (cell->neighbor_is_coarser(face_no))
+        {
+          const typename DoFHandler<dim>::cell_iterator neighbor = cell->neighbor(face_no);
+          const std::pair<unsigned int, unsigned int> neighbor_face =
+            cell->neighbor_of_coarser_neighbor(face_no);
+
+          scratch_data.fe_face_values.reinit(cell, face_no);
+          scratch_data.fe_subface_values_neighbor.reinit(neighbor, neighbor_face.first, neighbor_face.second);
+
+          integrate_face_rows(scratch_data.fe_face_values,
+                              scratch_data.fe_subface_values_neighbor,
+                              cell_block,
+                              next_neighbor_block(neighbor));
+        }
+      else
+        {
+          const typename DoFHandler<dim>::cell_iterator neighbor = cell->neighbor(face_no);
+
+          scratch_data.fe_face_values.reinit(cell, face_no);
+          scratch_data.fe_face_values_neighbor.reinit(neighbor, cell->neighbor_of_neighbor(face_no));
+
+          integrate_face_rows(scratch_data.fe_face_values,
+                              scratch_data.fe_face_values_neighbor,
+                              cell_block,
+                              next_neighbor_block(neighbor));
+        }
+    }
+  //
+  // the diagonal block is inverted while it is in cache, the scaled diagonal block is the identity
+  //
+  cell_block.gauss_jordan();
+
+  copy_data.rows.reinit(dofs_per_cell, copy_data.column_indices.size());
+  for (unsigned int i = 0; i < dofs_per_cell; ++i)
+    copy_data.rows(i, i) = 1.0;
+
+  FullMatrix<double> scaled_block(dofs_per_cell, dofs_per_cell);
+  for (unsigned int n = 0; n < n_neighbors; ++n)
+    {
+      cell_block.mmult(scaled_block, scratch_data.neighbor_blocks[n]);
+      copy_data.rows.fill(scaled_block, 0, (n + 1) * dofs_per_cell);
+    }
+
+  copy_data.rhs.reinit(dofs_per_cell);
+  cell_block.vmult(copy_data.rhs, cell_rhs);
+}
+
+template <int dim>
+void AdvectionProblem<dim>::copy_block_scaled_rows(const BlockScaledCopyData &copy_data)
+{
+  system_matrix.add(copy_data.row_indices, copy_data.column_indices, copy_data.rows);
+  right_hand_side.add(copy_data.row_indices, copy_data.rhs);
+}
+
+/**
+ * Face terms of the rows of the cell of @p fe_face_values, the same integrand as the u1_v1 and u2_v1 matrices of
+ * integrate_face_term
+ */
+template <int dim>
+void AdvectionProblem<dim>::integrate_face_rows(const FEFaceValuesBase<dim> &fe_face_values,
+                                                const FEFaceValuesBase<dim> &fe_face_values_neighbor,
+                                                FullMatrix<double> &cell_block,
+                                                FullMatrix<double> &neighbor_block)
+{
+  const unsigned int dofs_per_cell          = fe_face_values.dofs_per_cell;
+  const unsigned int neighbor_dofs_per_cell = fe_face_values_neighbor.dofs_per_cell;
+
+  for (unsigned int point = 0; point < fe_face_values.n_quadrature_points;
+       ++point)
+    {
+      const double beta_dot_n =
+        beta(fe_face_values.quadrature_point(point)) * fe_face_values.normal_vector(point);
+      if (beta_dot_n > 0)
+        {
+          for (unsigned int i = 0; i < dofs_per_cell; ++i)
+            for (unsigned int j = 0; j < dofs_per_cell; ++j)
+              cell_block(i, j) += beta_dot_n *                           //
+                                  fe_face_values.shape_value(j, point) * //
+                                  fe_face_values.shape_value(i, point) * //
+                                  fe_face_values.JxW(point);
+        }
+      else
+        {
+          for (unsigned int i = 0; i < dofs_per_cell; ++i)
+            for (unsigned int l = 0; l < neighbor_dofs_per_cell; ++l)
+              neighbor_block(i, l) +=
+                beta_dot_n *                                    //
+                fe_face_values_neighbor.shape_value(l, point) * //
+                fe_face_values.shape_value(i, point) *          //
+                fe_face_values.JxW(point);
+        }
+    }
+}
+
 template <int dim>
 void AdvectionProblem<dim>::integrate_cell_term(DoFInfo & dinfo,
                                                 CellInfo &info)
@@ -429,21 +927,196 @@ void AdvectionProblem<dim>::integrate_face_term(DoFInfo & dinfo1,
     }
 }
 
+/**
+ * Autotuning of the AIR parameters on the system of the first cycle. A copy of the system is block scaled as in solve,
+ * BoomerAMGAutotuner runs AIR as the solver for every candidate of its default AIR search space and the ranking is
+ * printed. The best candidate is saved to the autotune file and used by the solves of all cycles. With a parameter cache,
+ * the best candidate is also stored there under the fingerprint of the block scaled matrix.
+ */
+template <int dim>
+void AdvectionProblem<dim>::autotune()
+{
+  TimerOutput::Scope t(computing_timer, "autotune");
+
+  LA::MPI::SparseMatrix tuning_matrix;
+  tuning_matrix.copy_from(system_matrix);
+  LA::MPI::Vector tuning_rhs(right_hand_side);
+
+  if (parameters.block_scaling && !parameters.block_scaled_assembly)
+    precondition(tuning_matrix, tuning_rhs);
+
+  TrilinosWrappers::BoomerAMGParameters AMG_parameters(parameters.max_iterations, parameters.tolerance, TrilinosWrappers::BoomerAMGParameters::AIR_AMG);
+  AMG_parameters.set_parameter_value("distance_R",1);
+  AMG_parameters.set_parameter_values(parameters.boomeramg_overrides);
+
+  TrilinosWrappers::BoomerAMGAutotuner tuner(AMG_parameters,
+      TrilinosWrappers::BoomerAMGAutotuner::AdditionalData(parameters.max_iterations, parameters.tolerance));
+  tuner.add_default_search_space(TrilinosWrappers::BoomerAMGParameters::AIR_AMG);
+  tuner.tune(tuning_matrix, tuning_rhs);
+
+  pcout << "Autotuning ranking, setup plus solve time of the candidates that reached the tolerance first" << std::endl;
+
+  unsigned int rank = 0;
+  for (const auto &candidate : tuner.get_ranked_candidates())
+    {
+      std::ostringstream line;
+      line << std::setw(4) << ++rank;
+      for (const auto &value : candidate.values)
+        {
+          line << "  " << value.first << ' ';
+          TrilinosWrappers::ifpackHypreSolverPrecondParameters::write_parameter_value(line, value.second);
+        }
+      line << "  iterations " << candidate.statistics.n_iterations
+           << "  setup " << candidate.statistics.setup_time
+           << "  solve " << candidate.statistics.solve_time
+           << "  operator complexity " << candidate.statistics.operator_complexity
+           << (candidate.converged ? "" : "  not converged");
+      pcout << line.str() << std::endl;
+    }
+
+  tuned_values = tuner.get_best().values;
+  tuner.save(parameters.autotune_file);
+
+  pcout << "Best candidate saved to " << parameters.autotune_file << std::endl;
+
+  if (!parameters.parameter_cache.empty())
+    {
+      TrilinosWrappers::BoomerAMGParameterCache cache(parameters.parameter_cache, mpi_communicator);
+      cache.store(TrilinosWrappers::MatrixFingerprint::compute(tuning_matrix), tuner.get_best());
+
+      pcout << "Best candidate stored in " << parameters.parameter_cache << ", " << cache.n_entries() << " entries" << std::endl;
+    }
+}
+
+
+/**
+ * Set the AIR parameters of the solve: distance_R = 1, or the values selected by the autotuning, followed by the overrides
+ */
+template <int dim>
+void AdvectionProblem<dim>::set_AMG_parameters(TrilinosWrappers::BoomerAMGParameters &AMG_parameters) const
+{
+  /**
+   * Demonstrate changing a parameter value
+   */
+  AMG_parameters.set_parameter_value("distance_R",1);
+
+  if (parameters.autotune == "tune")
+    for (const auto &value : tuned_values)
+      AMG_parameters.set_parameter_value(value.first, value.second);
+  else if (parameters.autotune == "load")
+    AssertThrow(TrilinosWrappers::BoomerAMGAutotuner::load(parameters.autotune_file, AMG_parameters),
+                ExcMessage("Could not open the autotune file " + parameters.autotune_file + "."));
+
+  AMG_parameters.set_parameter_values(parameters.boomeramg_overrides);
+}
+
+
 template <int dim>
 void AdvectionProblem<dim>::solve(LA::MPI::Vector &solution)
 {
 
-	precondition(system_matrix, right_hand_side);
+	if (parameters.block_scaling && !parameters.block_scaled_assembly)
+		precondition(system_matrix, right_hand_side);
+
+	TrilinosWrappers::ifpackHypreSolverBase::Statistics AMG_statistics;
+
+	if (parameters.solver == "GMRES-AIR"){
+		TrilinosWrappers::BoomerAMGParameters AMG_parameters(TrilinosWrappers::BoomerAMGParameters::AIR_AMG);
+		set_AMG_parameters(AMG_parameters);
+		TrilinosWrappers::ifpackSolverParameters solver_parameters(parameters.max_iterations, parameters.tolerance, Hypre_Solver::GMRES);
+		solver_parameters.set_restart(parameters.gmres_restart);
+		TrilinosWrappers::BoomerAMG_PreconditionedSolver GMRES_solver(AMG_parameters, solver_parameters);
+
+		GMRES_solver.initialize(system_matrix);
+		GMRES_solver.solve(solution, right_hand_side);
+		AMG_statistics = GMRES_solver.get_statistics();
+	}else{
+		TrilinosWrappers::BoomerAMGParameters AMG_parameters(parameters.max_iterations, parameters.tolerance, TrilinosWrappers::BoomerAMGParameters::AIR_AMG);
+		set_AMG_parameters(AMG_parameters);
+		TrilinosWrappers::SolverBoomerAMG AMG_solver(AMG_parameters);
+		AMG_solver.set_parameter_cache(parameters.parameter_cache);
+
+		AMG_solver.initialize(system_matrix);
+		if (!parameters.parameter_cache.empty())
+			pcout << "Parameter cache " << (AMG_solver.parameter_cache_hit() ? "hit" : "miss") << std::endl;
+		AMG_solver.solve(solution, right_hand_side);
+		AMG_statistics = AMG_solver.get_statistics();
+	}
+
+	amg_setup_time = AMG_statistics.parameter_time + AMG_statistics.conversion_time + AMG_statistics.setup_time;
+
+}
+
+
+/**
+ * Verification of the reduced memory hierarchy mode of BoomerAMG_PreconditionedSolver with AIR, where the restriction
+ * filter applies. The system solved in the last cycle is solved again with GMRES-AIR, once with the full and once with the
+ * reduced hierarchy. The measured operator complexities are reported together with the number of hierarchy nonzeros they
+ * correspond to. The reduced run passes if its operator complexity is lower and its true relative residual is within a
+ * factor of 10 of the tolerance.
+ */
+template <int dim>
+void AdvectionProblem<dim>::verify_reduced_memory_hierarchy()
+{
+  TimerOutput::Scope t(computing_timer, "verify reduced hierarchy");
+
+  const IndexSet locally_owned_dofs = dof_handler.locally_owned_dofs();
+
+  LA::MPI::Vector full_solution(locally_owned_dofs, mpi_communicator);
+  LA::MPI::Vector reduced_solution(locally_owned_dofs, mpi_communicator);
+  LA::MPI::Vector residual(locally_owned_dofs, mpi_communicator);
+
+  TrilinosWrappers::ifpackHypreSolverBase::Statistics full_statistics, reduced_statistics;
+
+  for (const bool reduced : {false, true})
+    {
+      TrilinosWrappers::BoomerAMGParameters AMG_parameters(TrilinosWrappers::BoomerAMGParameters::AIR_AMG);
+      set_AMG_parameters(AMG_parameters);
+      AMG_parameters.set_parameter_value("hypre_print_level", 0);
+      TrilinosWrappers::ifpackSolverParameters solver_parameters(parameters.max_iterations, parameters.tolerance, Hypre_Solver::GMRES);
+      solver_parameters.set_restart(parameters.gmres_restart);
+      solver_parameters.set_print_level(0);
 
-	TrilinosWrappers::BoomerAMGParameters AMG_parameters(TrilinosWrappers::BoomerAMGParameters::AIR_AMG, Hypre_Chooser::Solver);
-    /**
-     * Demonstrate changing a parameter value
-     */
-	AMG_parameters.set_parameter_value("distance_R",1.0);
-	TrilinosWrappers::SolverBoomerAMG AMG_solver(AMG_parameters);
+      TrilinosWrappers::BoomerAMG_PreconditionedSolver GMRES_solver(AMG_parameters, solver_parameters,
+          TrilinosWrappers::BoomerAMG_PreconditionedSolver::AdditionalData(reduced));
 
-	AMG_solver.solve(system_matrix, right_hand_side, solution);
+      GMRES_solver.initialize(system_matrix);
+      GMRES_solver.solve(reduced ? reduced_solution : full_solution, right_hand_side);
 
+      (reduced ? reduced_statistics : full_statistics) = GMRES_solver.get_statistics();
+    }
+
+  const double rhs_norm = right_hand_side.l2_norm();
+  const double full_residual = system_matrix.residual(residual, full_solution, right_hand_side)/rhs_norm;
+  const double reduced_residual = system_matrix.residual(residual, reduced_solution, right_hand_side)/rhs_norm;
+  //
+  // the hierarchy holds operator_complexity times the nonzeros of the fine matrix, each stored as a value and a column index
+  //
+  const double n_fine_nonzeros = system_matrix.n_nonzero_elements();
+  const double full_nonzeros = full_statistics.operator_complexity*n_fine_nonzeros;
+  const double reduced_nonzeros = reduced_statistics.operator_complexity*n_fine_nonzeros;
+  const double bytes_per_nonzero = sizeof(double) + sizeof(HYPRE_Int);
+
+  pcout << "                       full hierarchy   reduced hierarchy" << std::endl
+        << "iterations             " << full_statistics.n_iterations << "   " << reduced_statistics.n_iterations << std::endl
+        << "relative residual      " << full_residual << "   " << reduced_residual << std::endl
+        << "operator complexity    " << full_statistics.operator_complexity << "   " << reduced_statistics.operator_complexity << std::endl
+        << "grid complexity        " << full_statistics.grid_complexity << "   " << reduced_statistics.grid_complexity << std::endl
+        << "hierarchy nonzeros     " << full_nonzeros << "   " << reduced_nonzeros << std::endl
+        << "setup time             " << full_statistics.setup_time << "   " << reduced_statistics.setup_time << std::endl
+        << "solve time             " << full_statistics.solve_time << "   " << reduced_statistics.solve_time << std::endl
+        << "operator memory saved  " << (full_nonzeros - reduced_nonzeros)*bytes_per_nonzero/(1024.0*1024.0) << " MB" << std::endl;
+
+  if (full_statistics.n_levels == 0)
+    {
+      pcout << "Reduced memory hierarchy verification FAILED, the hierarchy statistics are not available for this hypre release" << std::endl;
+      return;
+    }
+
+  const bool passed = (reduced_statistics.operator_complexity < full_statistics.operator_complexity) &&
+                      (reduced_residual <= 10.0*parameters.tolerance);
+
+  pcout << "Reduced memory hierarchy verification " << (passed ? "PASSED" : "FAILED") << std::endl;
 }
 
 
@@ -513,33 +1186,73 @@ void AdvectionProblem<dim>::output_results (const unsigned int cycle) const
 template <int dim>
 void AdvectionProblem<dim>::run()
 {
-  for (unsigned int cycle = 0; cycle < 4; ++cycle)
+  /**
+   * A scaling study runs a single cycle on a uniformly refined mesh
+   */
+  const unsigned int n_cycles = scaling_study.active() ? 1 : parameters.n_cycles;
+
+  for (unsigned int cycle = 0; cycle < n_cycles; ++cycle)
     {
 	  pcout << "Cycle " << cycle << std::endl;
 
-      if (cycle == 0)
-        {
-          GridGenerator::subdivided_hyper_cube(triangulation,4);
+      {
+        TimerOutput::Scope t(computing_timer, "setup");
 
-          triangulation.refine_global(2);
+        if (cycle == 0)
+          {
+            GridGenerator::subdivided_hyper_cube(triangulation,parameters.n_subdivisions);
 
-        }
-      else
-        refine_grid();
+            triangulation.refine_global(scaling_study.n_refinements());
+
+          }
+        else
+          refine_grid();
 
 
-      pcout << "Number of active cells:       "
-              << triangulation.n_active_cells() << std::endl;
+        pcout << "Number of active cells:       "
+                << triangulation.n_active_cells() << std::endl;
 
-      setup_system();
+        setup_system();
 
-      pcout << "Number of degrees of freedom: " << dof_handler.n_dofs()
-              << std::endl;
+        pcout << "Number of degrees of freedom: " << dof_handler.n_dofs()
+                << std::endl;
+      }
+
+      {
+        TimerOutput::Scope t(computing_timer, "assembly");
+        assemble_system();
+      }
+      if (parameters.autotune == "tune" && cycle == 0)
+        autotune();
+      {
+        TimerOutput::Scope t(computing_timer, "solve");
+        solve(solution);
+      }
+      if (parameters.write_solution)
+        {
+          TimerOutput::Scope t(computing_timer, "output");
+          output_results(cycle);
+        }
+    }
 
-      assemble_system();
-      solve(solution);
+  if (parameters.verify_reduced_memory_hierarchy)
+    verify_reduced_memory_hierarchy();
 
-      output_results(cycle);
+  if (scaling_study.active())
+    {
+      /**
+       * The block scaling is part of the solve, or of the assembly when it is applied during the assembly. The AMG setup
+       * is reported separately from the iterations
+       */
+      std::map<std::string, double> timings = computing_timer.get_summary_data(TimerOutput::total_wall_time);
+
+      scaling_study.set_problem_size(dof_handler.n_dofs());
+      scaling_study.add_phase_time("setup", timings["setup"]);
+      scaling_study.add_phase_time("assembly", timings["assembly"]);
+      scaling_study.add_phase_time("AMG setup", amg_setup_time);
+      scaling_study.add_phase_time("solve", timings["solve"] - amg_setup_time);
+      scaling_study.add_phase_time("output", timings["output"]);
+      scaling_study.report("scaling_results.csv", std::cout);
     }
 }
 
@@ -549,8 +1262,29 @@ int main(int argc, char *argv[])
   try
     {
 	  Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
-      AdvectionProblem<3> dgmethod;
-      dgmethod.run();
+      /**
+       * The configuration is read from an optional parameter file and --set options, see --help
+       */
+      ParameterHandler prm;
+      AdvectionParameters::declare_parameters(prm);
+      if (!BoomerAMGDrivers::parse_command_line(prm, argc, argv))
+        return 0;
+
+      AdvectionParameters parameters;
+      parameters.parse_parameters(prm);
+
+      MultithreadInfo::set_thread_limit(parameters.n_threads == 0 ? numbers::invalid_unsigned_int : parameters.n_threads);
+
+      if (parameters.dimension == 2)
+        {
+          AdvectionProblem<2> dgmethod(parameters);
+          dgmethod.run();
+        }
+      else
+        {
+          AdvectionProblem<3> dgmethod(parameters);
+          dgmethod.run();
+        }
     }
   catch (std::exception &exc)
     {
@@ -0,0 +1,17 @@
+#!/bin/sh
+#
+# Run the benchmark for a sweep of rank counts. All launches append to the results file of the parameter file,
+# the exit status is nonzero if any launch reports a regression against the baseline.
+#
+#   ./run_benchmarks.sh benchmark.prm "1 2 4 8"
+#
+PARAMETER_FILE=${1:-benchmark.prm}
+RANKS=${2:-"1 2 4"}
+MPIRUN=${MPIRUN:-mpirun}
+
+status=0
+for n in $RANKS; do
+	$MPIRUN -np $n ./bin/solver_benchmark $PARAMETER_FILE || status=1
+done
+
+exit $status
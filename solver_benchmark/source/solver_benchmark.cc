@@ -0,0 +1,1011 @@
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/base/function.h>
+#include <deal.II/base/timer.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/index_set.h>
+#include <deal.II/base/parameter_handler.h>
+#include <deal.II/lac/generic_linear_algebra.h>
+
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/full_matrix.h>
+#include <deal.II/lac/affine_constraints.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/sparsity_tools.h>
+
+#include <deal.II/lac/trilinos_vector.h>
+#include <deal.II/lac/trilinos_sparse_matrix.h>
+#include <deal.II/lac/trilinos_solver.h>
+#include <deal.II/lac/trilinos_precondition.h>
+
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/grid/tria_accessor.h>
+#include <deal.II/grid/tria_iterator.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/dofs/dof_accessor.h>
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/fe/fe_values.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/fe/fe_dgq.h>
+#include <deal.II/numerics/vector_tools.h>
+#include <deal.II/distributed/tria.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+//
+//
+///////////////////////////////////////////////
+//
+#include "BoomerAMG_solver.h"
+#include "cell_block_inverse.h"
+#include "driver_parameters.h"
+
+namespace LA =  dealii::LinearAlgebraTrilinos;
+
+using namespace dealii;
+
+/**
+ * A single point of the benchmark sweep
+ */
+struct BenchmarkCase{
+	/**
+	 * One of diffusion, supg or dg_advection
+	 */
+	std::string problem;
+	/**
+	 * Number of global refinements of the mesh
+	 */
+	unsigned int refinements = 0;
+	/**
+	 * Coefficient contrast. For the diffusion problem this is the ratio of the two diffusion coefficients, for the SUPG
+	 * problem the ratio of advection speed to diffusion. The pure advection problem has no coefficient and uses 0.
+	 */
+	double contrast = 0.0;
+	/**
+	 * Name of the solver configuration
+	 */
+	std::string solver;
+};
+
+/**
+ * Measured results of one benchmark case. One result is one line of the output file.
+ */
+struct BenchmarkResult{
+	BenchmarkCase benchmark_case;
+	unsigned int n_mpi_processes = 1;
+	types::global_dof_index n_dofs = 0;
+	double assembly_time = 0.0;
+	double setup_time = 0.0;
+	double solve_time = 0.0;
+	unsigned int n_iterations = 0;
+	double relative_residual = 0.0;
+	unsigned int n_levels = 0;
+	double grid_complexity = 0.0;
+	double operator_complexity = 0.0;
+	/**
+	 * Growth of the resident memory of the process over the case in MB, maximum over the ranks. It is measured while the
+	 * solver still holds its hierarchy, so it covers the setup of this case only and not memory left by earlier cases.
+	 */
+	double solver_memory = 0.0;
+
+	/**
+	 * Key identifying the case and process count, used to match results against a baseline
+	 */
+	std::string key() const{
+		std::ostringstream out;
+		out << benchmark_case.problem << '/' << benchmark_case.refinements << '/' << benchmark_case.contrast
+			<< '/' << benchmark_case.solver << '/' << n_mpi_processes;
+		return out.str();
+	}
+
+	static std::string csv_header(){
+		return "problem,refinements,contrast,solver,n_mpi_processes,n_dofs,assembly_time,setup_time,solve_time,"
+				"n_iterations,relative_residual,n_levels,grid_complexity,operator_complexity,solver_memory_MB";
+	}
+
+	void write_csv(std::ostream & out) const{
+		out << benchmark_case.problem << ',' << benchmark_case.refinements << ',' << benchmark_case.contrast << ','
+			<< benchmark_case.solver << ',' << n_mpi_processes << ',' << n_dofs << ',' << assembly_time << ','
+			<< setup_time << ',' << solve_time << ',' << n_iterations << ',' << relative_residual << ','
+			<< n_levels << ',' << grid_complexity << ',' << operator_complexity << ',' << solver_memory << '\n';
+	}
+};
+
+/**
+ * Read the results of a file written by BenchmarkResult::write_csv. The columns are located by the header, so baselines
+ * written before columns were added can still be read. Results are keyed by BenchmarkResult::key.
+ */
+std::map<std::string,BenchmarkResult> read_results(const std::string & filename){
+
+	std::map<std::string,BenchmarkResult> results;
+
+	std::ifstream in(filename);
+	AssertThrow(in, ExcMessage("Could not open the baseline file " + filename + "."));
+
+	std::string line;
+	std::vector<std::string> columns;
+
+	while (std::getline(in, line)){
+
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		const std::vector<std::string> fields = Utilities::split_string_list(line, ',');
+		//
+		// a header line appears at the start of the file and again after every appended run without one
+		//
+		if (fields.front() == "problem"){
+			columns = fields;
+			continue;
+		}
+
+		AssertThrow(fields.size() == columns.size(), ExcMessage("Malformed line in " + filename + ": " + line));
+
+		std::map<std::string,std::string> values;
+		for (unsigned int c=0; c<columns.size(); ++c)
+			values[columns[c]] = fields[c];
+
+		auto number = [&values](const std::string & column){
+			const auto value = values.find(column);
+			return (value == values.end()) ? 0.0 : Utilities::string_to_double(value->second);
+		};
+
+		BenchmarkResult result;
+		result.benchmark_case.problem = values["problem"];
+		result.benchmark_case.refinements = number("refinements");
+		result.benchmark_case.contrast = number("contrast");
+		result.benchmark_case.solver = values["solver"];
+		result.n_mpi_processes = number("n_mpi_processes");
+		result.n_dofs = number("n_dofs");
+		result.assembly_time = number("assembly_time");
+		result.setup_time = number("setup_time");
+		result.solve_time = number("solve_time");
+		result.n_iterations = number("n_iterations");
+		result.relative_residual = number("relative_residual");
+		result.n_levels = number("n_levels");
+		result.grid_complexity = number("grid_complexity");
+		result.operator_complexity = number("operator_complexity");
+		result.solver_memory = number("solver_memory_MB");
+
+		results[result.key()] = result;
+	}
+
+	return results;
+
+}
+//
+// Resident memory of this process in MB
+//
+double resident_memory(){
+
+	return Utilities::System::get_memory_stats().VmRSS/1024.0;
+
+}
+//
+// Coefficient bands of the diffusion problem, the same layout as in diffusion_amg_preconditioner
+//
+double Lx=1.0,Ly=1.0;
+double dx=0.2;
+int nx=3;
+
+bool in_low_diffusion_band(const Point<2> & location){
+
+	const double L1 = (Lx-(dx*nx))/((double)(nx-1));
+
+	for (int n=1;n<=nx;++n){
+		const double r_strt = (dx+L1)*( (double)(n-1) );
+		const double r_end = r_strt + dx;
+
+		if (location(0)>=r_strt && location(0)<=r_end){
+			if (n%3==0)
+				return true;
+			else if (n%3==1 && location(1) > Ly/7 && location(1)< Ly*0.6)
+				return true;
+			else if (n%3==2 && (location(1) < Ly/4.0 || location(1)> Ly*0.75))
+				return true;
+		}
+	}
+
+	return false;
+
+}
+//
+// Rotating wind and inflow data of the DG advection problem, the same as in simple_advection
+//
+Tensor<1,2> rotating_wind(const Point<2> & p){
+
+	Tensor<1,2> wind_field;
+	wind_field[0] = -p(1);
+	wind_field[1] = p(0);
+	wind_field /= wind_field.norm();
+
+	return wind_field;
+
+}
+
+double inflow_value(const Point<2> & p){
+
+	return (p(0) < 0.5) ? 1.0 : 0.0;
+
+}
+
+/**
+ * Benchmark of the solver wrappers over a sweep of problems, mesh sizes, coefficient contrasts and solver configurations.
+ * Three problems are assembled:
+ * - diffusion: Q1 diffusion with the banded coefficient of diffusion_amg_preconditioner, the coefficient is 1 outside and
+ *   1/contrast inside the bands.
+ * - supg: Q1 SUPG advection diffusion on [-1,1]^2 as in advection_difussion_supg, with unit diffusion and speed equal to
+ *   the contrast, i.e. the driver's default diffusion with its speed set to the contrast.
+ * - dg_advection: DGQ1 upwind discretization of the rotating wind problem of simple_advection on the unit square, scaled
+ *   by the inverses of its cell diagonal blocks as by the driver's default block scaling, so AIR is given the operator
+ *   the driver gives it.
+ *
+ * The assembly of the three problems is a deliberate copy of the drivers. All problems have to be assembled in one program
+ * on the same mesh and DoFHandler, and keeping the copies separate means that a change to a driver does not silently
+ * change the problems the baseline results were measured on.
+ *
+ * Each solver configuration is timed over a number of repetitions from a zero initial guess and the fastest repetition is
+ * kept, which makes the times less sensitive to noise. All results of a case, iterations, residual, hierarchy statistics
+ * and memory, are those of the kept repetition. The true relative residual is computed from the solution so that all
+ * solvers are measured alike. The memory is the growth of the resident memory from the start of the case, since the high
+ * water mark of the process only reflects the largest case run so far. The rank count is that of the MPI launch and is part
+ * of every result, so a rank sweep is a sequence of launches appending to the same results file.
+ *
+ * If a baseline file is given, every result is compared to the baseline result with the same key and a regression is
+ * reported if the time, iteration count or operator complexity grew beyond the tolerances. The program then exits with
+ * a nonzero status, so it can be used in an automated check.
+ */
+class SolverBenchmark
+{
+public:
+	SolverBenchmark(ParameterHandler & prm);
+	int run();
+
+	static void declare_parameters(ParameterHandler & prm);
+
+private:
+	void make_grid(const std::string & problem, const unsigned int refinements);
+	void setup_system(const std::string & problem);
+	void assemble_diffusion(const double contrast);
+	void assemble_supg(const double contrast);
+	void assemble_dg_advection();
+	void solve(BenchmarkResult & result);
+	void time_hypre_solver(TrilinosWrappers::ifpackHypreSolverBase & solver, BenchmarkResult & result);
+	bool compare_to_baseline(const std::vector<BenchmarkResult> & results) const;
+	void write_results(const std::vector<BenchmarkResult> & results) const;
+
+	static bool is_symmetric(const std::string & problem);
+	static bool needs_symmetric_matrix(const std::string & solver);
+
+	MPI_Comm mpi_communicator;
+
+	parallel::distributed::Triangulation<2> triangulation;
+	DoFHandler<2>    dof_handler;
+	std::unique_ptr<FiniteElement<2>> fe;
+
+	IndexSet locally_owned_dofs;
+	IndexSet locally_relevant_dofs;
+
+	AffineConstraints<double> constraints;
+
+	LA::MPI::SparseMatrix system_matrix;
+	LA::MPI::Vector       system_rhs;
+
+	ConditionalOStream pcout;
+
+	std::vector<std::string> problems;
+	std::vector<unsigned int> refinements;
+	std::vector<double> contrasts;
+	std::vector<std::string> solvers;
+
+	unsigned int repetitions;
+	unsigned int max_iterations;
+	double tolerance;
+
+	std::string output_file;
+	std::string baseline_file;
+	double time_tolerance;
+	unsigned int iteration_tolerance;
+	double complexity_tolerance;
+};
+
+
+SolverBenchmark::SolverBenchmark(ParameterHandler & prm)
+: mpi_communicator(MPI_COMM_WORLD)
+, triangulation(mpi_communicator)
+, dof_handler(triangulation)
+, pcout(std::cout,
+        (Utilities::MPI::this_mpi_process(mpi_communicator) == 0))
+{
+	prm.enter_subsection("Sweep");
+	problems = Utilities::split_string_list(prm.get("Problems"));
+	for (const auto & n : Utilities::split_string_list(prm.get("Refinements")))
+		refinements.push_back(Utilities::string_to_int(n));
+	for (const auto & c : Utilities::split_string_list(prm.get("Coefficient contrasts")))
+		contrasts.push_back(Utilities::string_to_double(c));
+	solvers = Utilities::split_string_list(prm.get("Solvers"));
+	repetitions = prm.get_integer("Repetitions");
+	prm.leave_subsection();
+
+	prm.enter_subsection("Solver");
+	max_iterations = prm.get_integer("Max iterations");
+	tolerance = prm.get_double("Tolerance");
+	prm.leave_subsection();
+
+	prm.enter_subsection("Output");
+	output_file = prm.get("Results file");
+	baseline_file = prm.get("Baseline file");
+	time_tolerance = prm.get_double("Time tolerance");
+	iteration_tolerance = prm.get_integer("Iteration tolerance");
+	complexity_tolerance = prm.get_double("Complexity tolerance");
+	prm.leave_subsection();
+
+	AssertThrow(repetitions > 0, ExcMessage("At least one repetition is needed."));
+}
+
+
+void SolverBenchmark::declare_parameters(ParameterHandler & prm){
+
+	prm.enter_subsection("Sweep");
+	prm.declare_entry("Problems", "diffusion, supg, dg_advection",
+			Patterns::List(Patterns::Selection("diffusion|supg|dg_advection")),
+			"Problems to assemble");
+	prm.declare_entry("Refinements", "5, 6, 7",
+			Patterns::List(Patterns::Integer(1)),
+			"Numbers of global refinements of the unit square");
+	prm.declare_entry("Coefficient contrasts", "1e2, 1e5",
+			Patterns::List(Patterns::Double(1.0)),
+			"Ratio of the diffusion coefficients for the diffusion problem, ratio of speed to diffusion for the supg problem");
+	prm.declare_entry("Solvers", "BoomerAMG, AIR, PCG-BoomerAMG, GMRES-BoomerAMG, GMRES-AIR, ML-CG",
+			Patterns::List(Patterns::Selection("BoomerAMG|AIR|PCG-BoomerAMG|GMRES-BoomerAMG|GMRES-AIR|ML-CG")),
+			"Solver configurations. PCG-BoomerAMG and ML-CG are only run on the symmetric diffusion problem.");
+	prm.declare_entry("Repetitions", "3", Patterns::Integer(1),
+			"Number of repetitions of each solve, the fastest is reported");
+	prm.leave_subsection();
+
+	prm.enter_subsection("Solver");
+	prm.declare_entry("Max iterations", "500", Patterns::Integer(1), "Maximum number of iterations");
+	prm.declare_entry("Tolerance", "1e-8", Patterns::Double(0.0), "Relative residual tolerance");
+	prm.leave_subsection();
+
+	prm.enter_subsection("Output");
+	prm.declare_entry("Results file", "benchmark_results.csv", Patterns::FileName(),
+			"CSV file the results are appended to");
+	prm.declare_entry("Baseline file", "", Patterns::Anything(),
+			"Results file of an earlier run to compare against, no comparison if empty");
+	prm.declare_entry("Time tolerance", "0.2", Patterns::Double(0.0),
+			"Relative growth of setup plus solve time counted as a regression");
+	prm.declare_entry("Iteration tolerance", "2", Patterns::Integer(0),
+			"Growth of the iteration count counted as a regression");
+	prm.declare_entry("Complexity tolerance", "0.05", Patterns::Double(0.0),
+			"Relative growth of the operator complexity counted as a regression");
+	prm.leave_subsection();
+
+}
+
+
+bool SolverBenchmark::is_symmetric(const std::string & problem){
+
+	return problem == "diffusion";
+
+}
+
+
+bool SolverBenchmark::needs_symmetric_matrix(const std::string & solver){
+
+	return solver == "PCG-BoomerAMG" || solver == "ML-CG";
+
+}
+
+
+void SolverBenchmark::make_grid(const std::string & problem, const unsigned int n_refinements){
+
+	triangulation.clear();
+	if (problem == "supg")
+		GridGenerator::hyper_cube(triangulation, -1, 1);
+	else
+		GridGenerator::hyper_cube(triangulation, 0, 1);
+	triangulation.refine_global(n_refinements);
+
+}
+
+
+void SolverBenchmark::setup_system(const std::string & problem){
+
+	if (problem == "dg_advection")
+		fe = std_cxx14::make_unique<FE_DGQ<2>>(1);
+	else
+		fe = std_cxx14::make_unique<FE_Q<2>>(1);
+
+	dof_handler.distribute_dofs(*fe);
+
+	locally_owned_dofs = dof_handler.locally_owned_dofs();
+	DoFTools::extract_locally_relevant_dofs(dof_handler, locally_relevant_dofs);
+
+	system_rhs.reinit(locally_owned_dofs, mpi_communicator);
+
+	constraints.clear();
+	constraints.reinit(locally_relevant_dofs);
+	if (problem != "dg_advection")
+		VectorTools::interpolate_boundary_values(dof_handler,
+		                                         0,
+		                                         Functions::ZeroFunction<2>(),
+		                                         constraints);
+	constraints.close();
+
+	DynamicSparsityPattern dsp(locally_relevant_dofs);
+
+	if (problem == "dg_advection")
+		DoFTools::make_flux_sparsity_pattern(dof_handler, dsp);
+	else
+		DoFTools::make_sparsity_pattern(dof_handler, dsp, constraints, false);
+
+	SparsityTools::distribute_sparsity_pattern(
+	  dsp,
+	  dof_handler.n_locally_owned_dofs_per_processor(),
+	  mpi_communicator,
+	  locally_relevant_dofs);
+
+	system_matrix.reinit(locally_owned_dofs,
+	                     locally_owned_dofs,
+	                     dsp,
+	                     mpi_communicator);
+
+}
+
+
+void SolverBenchmark::assemble_diffusion(const double contrast){
+
+	QGauss<2> quadrature_formula(2);
+
+	FEValues<2> fe_values(*fe,
+	                      quadrature_formula,
+	                      update_values | update_gradients | update_JxW_values);
+
+	const unsigned int dofs_per_cell = fe->dofs_per_cell;
+	const unsigned int n_q_points    = quadrature_formula.size();
+
+	FullMatrix<double> cell_matrix(dofs_per_cell, dofs_per_cell);
+	Vector<double>     cell_rhs(dofs_per_cell);
+
+	std::vector<types::global_dof_index> local_dof_indices(dofs_per_cell);
+
+	for (const auto &cell : dof_handler.active_cell_iterators())
+		if (cell->is_locally_owned())
+		{
+			cell_matrix = 0;
+			cell_rhs    = 0;
+
+			fe_values.reinit(cell);
+			//
+			// the cell is in a band if any of its vertices is
+			//
+			bool in_band = false;
+			for (unsigned int v=0; v<GeometryInfo<2>::vertices_per_cell && !in_band; ++v)
+				in_band = in_low_diffusion_band(cell->vertex(v));
+
+			const double D = in_band ? 1.0/contrast : 1.0;
+
+			for (unsigned int q_index = 0; q_index < n_q_points; ++q_index)
+			{
+				for (unsigned int i = 0; i < dofs_per_cell; ++i)
+					for (unsigned int j = 0; j < dofs_per_cell; ++j)
+						cell_matrix(i, j) += D*(fe_values.shape_grad(i, q_index) *
+						                        fe_values.shape_grad(j, q_index) *
+						                        fe_values.JxW(q_index));
+
+				for (unsigned int i = 0; i < dofs_per_cell; ++i)
+					cell_rhs(i) += fe_values.shape_value(i, q_index) * fe_values.JxW(q_index);
+			}
+
+			cell->get_dof_indices(local_dof_indices);
+			constraints.distribute_local_to_global(cell_matrix,
+			                                       cell_rhs,
+			                                       local_dof_indices,
+			                                       system_matrix,
+			                                       system_rhs);
+		}
+
+	system_matrix.compress(VectorOperation::add);
+	system_rhs.compress(VectorOperation::add);
+
+}
+
+
+void SolverBenchmark::assemble_supg(const double contrast){
+
+	const double nu = 1.0;
+
+	Tensor<1,2> velocity;
+	velocity[0] = std::sqrt(2.0)/2.0*contrast;
+	velocity[1] = std::sqrt(2.0)/2.0*contrast;
+
+	QGauss<2> quadrature_formula(2);
+
+	FEValues<2> fe_values(*fe,
+	                      quadrature_formula,
+	                      update_values | update_gradients | update_JxW_values);
+
+	const unsigned int dofs_per_cell = fe->dofs_per_cell;
+	const unsigned int n_q_points    = quadrature_formula.size();
+
+	FullMatrix<double> cell_matrix(dofs_per_cell, dofs_per_cell);
+	Vector<double>     cell_rhs(dofs_per_cell);
+
+	std::vector<types::global_dof_index> local_dof_indices(dofs_per_cell);
+
+	for (const auto &cell : dof_handler.active_cell_iterators())
+		if (cell->is_locally_owned())
+		{
+			cell_matrix = 0;
+			cell_rhs    = 0;
+
+			fe_values.reinit(cell);
+			//
+			// stabilization parameter of supg.cc for an axis aligned cell
+			//
+			const double h_xi = ( cell->vertex(3)(0) + cell->vertex(1)(0) - cell->vertex(2)(0) - cell->vertex(0)(0) )/2.0;
+			const double h_etta = ( cell->vertex(3)(1) + cell->vertex(2)(1) - cell->vertex(0)(1) - cell->vertex(1)(1) )/2.0;
+
+			const double Pe_xi = velocity[0]*h_xi/2.0/nu;
+			const double Pe_etta = velocity[1]*h_etta/2.0/nu;
+
+			const double etta_bar = 1.0/std::tanh(Pe_xi) - 1.0/Pe_xi;
+			const double xi_bar = 1.0/std::tanh(Pe_etta) - 1.0/Pe_etta;
+
+			const double tau = (etta_bar*velocity[1]*h_etta + xi_bar*velocity[0]*h_xi)/2.0/velocity.norm_square();
+
+			for (unsigned int q_index = 0; q_index < n_q_points; ++q_index)
+			{
+				for (unsigned int i = 0; i < dofs_per_cell; ++i)
+				{
+					const double streamline_test = fe_values.shape_grad(i, q_index)*velocity;
+
+					for (unsigned int j = 0; j < dofs_per_cell; ++j)
+						cell_matrix(i, j) += (nu*(fe_values.shape_grad(i, q_index) * fe_values.shape_grad(j, q_index))
+						                      + (velocity * fe_values.shape_grad(j, q_index)) *
+						                        (fe_values.shape_value(i, q_index) + tau*streamline_test))
+						                     * fe_values.JxW(q_index);
+
+					cell_rhs(i) += (fe_values.shape_value(i, q_index) + tau*streamline_test) * fe_values.JxW(q_index);
+				}
+			}
+
+			cell->get_dof_indices(local_dof_indices);
+			constraints.distribute_local_to_global(cell_matrix,
+			                                       cell_rhs,
+			                                       local_dof_indices,
+			                                       system_matrix,
+			                                       system_rhs);
+		}
+
+	system_matrix.compress(VectorOperation::add);
+	system_rhs.compress(VectorOperation::add);
+
+}
+
+
+void SolverBenchmark::assemble_dg_advection(){
+
+	QGauss<2> quadrature_formula(2);
+	QGauss<1> face_quadrature_formula(2);
+
+	FEValues<2> fe_values(*fe,
+	                      quadrature_formula,
+	                      update_values | update_gradients | update_quadrature_points | update_JxW_values);
+	FEFaceValues<2> fe_face_values(*fe,
+	                               face_quadrature_formula,
+	                               update_values | update_quadrature_points | update_normal_vectors | update_JxW_values);
+	FEFaceValues<2> fe_face_values_neighbor(*fe,
+	                                        face_quadrature_formula,
+	                                        update_values | update_quadrature_points);
+
+	const unsigned int dofs_per_cell = fe->dofs_per_cell;
+
+	FullMatrix<double> cell_matrix(dofs_per_cell, dofs_per_cell);
+	FullMatrix<double> coupling_matrix(dofs_per_cell, dofs_per_cell);
+	Vector<double>     cell_rhs(dofs_per_cell);
+
+	std::vector<types::global_dof_index> local_dof_indices(dofs_per_cell);
+	std::vector<types::global_dof_index> neighbor_dof_indices(dofs_per_cell);
+	//
+	// every cell assembles the upwind flux over its outflow faces: the outflow trace couples into its own rows and
+	// into the rows of the downwind neighbor, so each interior face is visited once
+	//
+	for (const auto &cell : dof_handler.active_cell_iterators())
+		if (cell->is_locally_owned())
+		{
+			cell_matrix = 0;
+			cell_rhs    = 0;
+
+			fe_values.reinit(cell);
+			cell->get_dof_indices(local_dof_indices);
+
+			for (unsigned int q_index = 0; q_index < quadrature_formula.size(); ++q_index)
+			{
+				const Tensor<1,2> beta = rotating_wind(fe_values.quadrature_point(q_index));
+				for (unsigned int i = 0; i < dofs_per_cell; ++i)
+					for (unsigned int j = 0; j < dofs_per_cell; ++j)
+						cell_matrix(i, j) += -(beta * fe_values.shape_grad(i, q_index)) *
+						                      fe_values.shape_value(j, q_index) *
+						                      fe_values.JxW(q_index);
+			}
+
+			for (unsigned int face_number = 0; face_number < GeometryInfo<2>::faces_per_cell; ++face_number)
+			{
+				fe_face_values.reinit(cell, face_number);
+
+				if (cell->face(face_number)->at_boundary())
+				{
+					for (unsigned int q_index = 0; q_index < face_quadrature_formula.size(); ++q_index)
+					{
+						const double beta_dot_n = rotating_wind(fe_face_values.quadrature_point(q_index)) *
+						                          fe_face_values.normal_vector(q_index);
+						for (unsigned int i = 0; i < dofs_per_cell; ++i)
+						{
+							if (beta_dot_n > 0)
+								for (unsigned int j = 0; j < dofs_per_cell; ++j)
+									cell_matrix(i, j) += beta_dot_n *
+									                     fe_face_values.shape_value(j, q_index) *
+									                     fe_face_values.shape_value(i, q_index) *
+									                     fe_face_values.JxW(q_index);
+							else
+								cell_rhs(i) += -beta_dot_n *
+								               inflow_value(fe_face_values.quadrature_point(q_index)) *
+								               fe_face_values.shape_value(i, q_index) *
+								               fe_face_values.JxW(q_index);
+						}
+					}
+					continue;
+				}
+
+				const auto neighbor = cell->neighbor(face_number);
+				Assert(!neighbor->has_children(), ExcNotImplemented());
+
+				fe_face_values_neighbor.reinit(neighbor, cell->neighbor_of_neighbor(face_number));
+				neighbor->get_dof_indices(neighbor_dof_indices);
+
+				coupling_matrix = 0;
+				for (unsigned int q_index = 0; q_index < face_quadrature_formula.size(); ++q_index)
+				{
+					Assert(fe_face_values.quadrature_point(q_index).distance(fe_face_values_neighbor.quadrature_point(q_index))
+					       < 1e-12*cell->diameter(), ExcInternalError());
+
+					const double beta_dot_n = rotating_wind(fe_face_values.quadrature_point(q_index)) *
+					                          fe_face_values.normal_vector(q_index);
+					if (beta_dot_n <= 0)
+						continue;
+
+					for (unsigned int j = 0; j < dofs_per_cell; ++j)
+					{
+						for (unsigned int i = 0; i < dofs_per_cell; ++i)
+							cell_matrix(i, j) += beta_dot_n *
+							                     fe_face_values.shape_value(j, q_index) *
+							                     fe_face_values.shape_value(i, q_index) *
+							                     fe_face_values.JxW(q_index);
+						for (unsigned int k = 0; k < dofs_per_cell; ++k)
+							coupling_matrix(k, j) += -beta_dot_n *
+							                         fe_face_values.shape_value(j, q_index) *
+							                         fe_face_values_neighbor.shape_value(k, q_index) *
+							                         fe_face_values.JxW(q_index);
+					}
+				}
+
+				system_matrix.add(neighbor_dof_indices, local_dof_indices, coupling_matrix);
+			}
+
+			system_matrix.add(local_dof_indices, cell_matrix);
+			system_rhs.add(local_dof_indices, cell_rhs);
+		}
+
+	system_matrix.compress(VectorOperation::add);
+	system_rhs.compress(VectorOperation::add);
+	//
+	// block scaling as in simple_advection, the dofs of a cell are numbered consecutively
+	//
+	TrilinosWrappers::CellBlockInverse block_inverse;
+	block_inverse.initialize(system_matrix, fe->dofs_per_cell);
+	block_inverse.scale_rows(system_matrix);
+
+	const LA::MPI::Vector unscaled_rhs(system_rhs);
+	block_inverse.vmult(system_rhs, unscaled_rhs);
+
+}
+
+
+void SolverBenchmark::time_hypre_solver(TrilinosWrappers::ifpackHypreSolverBase & solver, BenchmarkResult & result){
+
+	LA::MPI::Vector solution(locally_owned_dofs, mpi_communicator);
+	LA::MPI::Vector residual(locally_owned_dofs, mpi_communicator);
+
+	const double initial_memory = resident_memory();
+
+	for (unsigned int repetition=0; repetition<repetitions; ++repetition){
+
+		solution = 0.0;
+
+		solver.reset_statistics();
+		solver.initialize(system_matrix);
+		solver.solve(solution, system_rhs);
+
+		const TrilinosWrappers::ifpackHypreSolverBase::Statistics statistics = solver.get_statistics();
+		const double setup_time = statistics.parameter_time + statistics.conversion_time + statistics.setup_time;
+		const double solver_memory = Utilities::MPI::max(resident_memory() - initial_memory, mpi_communicator);
+
+		if (repetition == 0 || setup_time + statistics.solve_time < result.setup_time + result.solve_time){
+			result.setup_time = setup_time;
+			result.solve_time = statistics.solve_time;
+			result.n_iterations = statistics.n_iterations;
+			result.relative_residual = system_matrix.residual(residual, solution, system_rhs)/system_rhs.l2_norm();
+			result.n_levels = statistics.n_levels;
+			result.grid_complexity = statistics.grid_complexity;
+			result.operator_complexity = statistics.operator_complexity;
+			result.solver_memory = solver_memory;
+		}
+	}
+
+}
+
+
+void SolverBenchmark::solve(BenchmarkResult & result){
+
+	const std::string & solver_name = result.benchmark_case.solver;
+
+	if (solver_name == "BoomerAMG" || solver_name == "AIR"){
+
+		TrilinosWrappers::BoomerAMGParameters AMG_parameters(max_iterations, tolerance,
+				(solver_name == "AIR") ? TrilinosWrappers::BoomerAMGParameters::AIR_AMG
+				                       : TrilinosWrappers::BoomerAMGParameters::CLASSICAL_AMG);
+		AMG_parameters.set_parameter_value("hypre_print_level", 0);
+		TrilinosWrappers::SolverBoomerAMG AMG_solver(AMG_parameters);
+		time_hypre_solver(AMG_solver, result);
+
+	}else if (solver_name == "ML-CG"){
+
+		LA::MPI::Vector solution(locally_owned_dofs, mpi_communicator);
+		LA::MPI::Vector residual(locally_owned_dofs, mpi_communicator);
+
+		const double initial_memory = resident_memory();
+
+		for (unsigned int repetition=0; repetition<repetitions; ++repetition){
+
+			solution = 0.0;
+
+			Timer timer(mpi_communicator, true);
+			LA::MPI::PreconditionAMG preconditioner;
+			LA::MPI::PreconditionAMG::AdditionalData data;
+			data.elliptic = true;
+			preconditioner.initialize(system_matrix, data);
+			timer.stop();
+			const double setup_time = Utilities::MPI::max(timer.wall_time(), mpi_communicator);
+
+			SolverControl solver_control(max_iterations, tolerance*system_rhs.l2_norm());
+			LA::SolverCG solver(solver_control);
+
+			timer.restart();
+			solver.solve(system_matrix, solution, system_rhs, preconditioner);
+			timer.stop();
+			const double solve_time = Utilities::MPI::max(timer.wall_time(), mpi_communicator);
+			const double solver_memory = Utilities::MPI::max(resident_memory() - initial_memory, mpi_communicator);
+
+			if (repetition == 0 || setup_time + solve_time < result.setup_time + result.solve_time){
+				result.setup_time = setup_time;
+				result.solve_time = solve_time;
+				result.n_iterations = solver_control.last_step();
+				result.relative_residual = system_matrix.residual(residual, solution, system_rhs)/system_rhs.l2_norm();
+				result.solver_memory = solver_memory;
+			}
+		}
+
+	}else{
+
+		const bool use_AIR = (solver_name == "GMRES-AIR");
+
+		TrilinosWrappers::BoomerAMGParameters AMG_parameters(use_AIR ? TrilinosWrappers::BoomerAMGParameters::AIR_AMG
+		                                                             : TrilinosWrappers::BoomerAMGParameters::CLASSICAL_AMG);
+		AMG_parameters.set_parameter_value("hypre_print_level", 0);
+		TrilinosWrappers::ifpackSolverParameters solver_parameters(max_iterations, tolerance,
+				(solver_name == "PCG-BoomerAMG") ? Hypre_Solver::PCG : Hypre_Solver::GMRES);
+		solver_parameters.set_print_level(0);
+		TrilinosWrappers::BoomerAMG_PreconditionedSolver preconditioned_solver(AMG_parameters, solver_parameters);
+		time_hypre_solver(preconditioned_solver, result);
+
+	}
+
+}
+
+
+bool SolverBenchmark::compare_to_baseline(const std::vector<BenchmarkResult> & results) const{
+
+	const std::map<std::string,BenchmarkResult> baseline = read_results(baseline_file);
+
+	bool regression = false;
+
+	pcout << std::endl << "Comparison with " << baseline_file << std::endl;
+
+	for (const auto & result : results){
+
+		const auto reference = baseline.find(result.key());
+		if (reference == baseline.end()){
+			pcout << "  " << std::left << std::setw(40) << result.key() << " no baseline" << std::endl;
+			continue;
+		}
+
+		const double time = result.setup_time + result.solve_time;
+		const double reference_time = reference->second.setup_time + reference->second.solve_time;
+
+		std::vector<std::string> failures;
+		if (time > (1.0+time_tolerance)*reference_time)
+			failures.push_back("time");
+		if (result.n_iterations > reference->second.n_iterations + iteration_tolerance)
+			failures.push_back("iterations");
+		if (result.operator_complexity > (1.0+complexity_tolerance)*reference->second.operator_complexity)
+			failures.push_back("complexity");
+
+		pcout << "  " << std::left << std::setw(40) << result.key()
+			  << " time " << time << " (" << reference_time << ")"
+			  << " iterations " << result.n_iterations << " (" << reference->second.n_iterations << ")"
+			  << " operator complexity " << result.operator_complexity << " (" << reference->second.operator_complexity << ")";
+
+		if (failures.empty())
+			pcout << " ok" << std::endl;
+		else{
+			regression = true;
+			pcout << " REGRESSION in";
+			for (const auto & failure : failures)
+				pcout << ' ' << failure;
+			pcout << std::endl;
+		}
+	}
+
+	return regression;
+
+}
+
+
+void SolverBenchmark::write_results(const std::vector<BenchmarkResult> & results) const{
+
+	if (Utilities::MPI::this_mpi_process(mpi_communicator) != 0)
+		return;
+	//
+	// results are appended, so that the launches of a rank sweep collect in one file
+	//
+	const bool new_file = !std::ifstream(output_file);
+
+	std::ofstream out(output_file, std::ios::app);
+	AssertThrow(out, ExcMessage("Could not open " + output_file + " for writing."));
+
+	out.precision(8);
+	if (new_file)
+		out << BenchmarkResult::csv_header() << '\n';
+
+	for (const auto & result : results)
+		result.write_csv(out);
+
+}
+
+
+int SolverBenchmark::run(){
+
+	std::vector<BenchmarkResult> results;
+
+	for (const auto & problem : problems)
+		for (const unsigned int n_refinements : refinements){
+
+			make_grid(problem, n_refinements);
+			setup_system(problem);
+
+			pcout << "Problem " << problem << ", " << n_refinements << " refinements, "
+				  << dof_handler.n_dofs() << " dofs on " << Utilities::MPI::n_mpi_processes(mpi_communicator)
+				  << " processes" << std::endl;
+
+			const std::vector<double> problem_contrasts = (problem == "dg_advection") ? std::vector<double>(1, 0.0) : contrasts;
+
+			for (const double contrast : problem_contrasts){
+
+				system_matrix = 0;
+				system_rhs = 0;
+
+				Timer timer(mpi_communicator, true);
+				if (problem == "diffusion")
+					assemble_diffusion(contrast);
+				else if (problem == "supg")
+					assemble_supg(contrast);
+				else
+					assemble_dg_advection();
+				timer.stop();
+				const double assembly_time = Utilities::MPI::max(timer.wall_time(), mpi_communicator);
+
+				for (const auto & solver : solvers){
+
+					if (needs_symmetric_matrix(solver) && !is_symmetric(problem))
+						continue;
+
+					BenchmarkResult result;
+					result.benchmark_case.problem = problem;
+					result.benchmark_case.refinements = n_refinements;
+					result.benchmark_case.contrast = contrast;
+					result.benchmark_case.solver = solver;
+					result.n_mpi_processes = Utilities::MPI::n_mpi_processes(mpi_communicator);
+					result.n_dofs = dof_handler.n_dofs();
+					result.assembly_time = assembly_time;
+
+					solve(result);
+
+					pcout << "  " << std::left << std::setw(16) << solver
+						  << " contrast " << std::setw(8) << contrast
+						  << " setup " << std::setw(12) << result.setup_time
+						  << " solve " << std::setw(12) << result.solve_time
+						  << " iterations " << std::setw(5) << result.n_iterations
+						  << " residual " << result.relative_residual << std::endl;
+
+					results.push_back(result);
+				}
+			}
+		}
+
+	write_results(results);
+
+	//
+	// every process reads the baseline, so that an error reading it is raised on all of them instead of leaving the others
+	// waiting in a collective call
+	//
+	bool regression = false;
+	if (!baseline_file.empty())
+		regression = compare_to_baseline(results);
+
+	return Utilities::MPI::max((int)regression, mpi_communicator);
+
+}
+
+
+
+int main(int argc, char *argv[])
+{
+  try
+    {
+      Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+
+      ParameterHandler prm;
+      SolverBenchmark::declare_parameters(prm);
+
+      if (!BoomerAMGDrivers::parse_command_line(prm, argc, argv))
+        return 0;
+
+      SolverBenchmark benchmark(prm);
+      return benchmark.run();
+    }
+  catch (std::exception &exc)
+    {
+      std::cerr << std::endl
+                << std::endl
+                << "----------------------------------------------------"
+                << std::endl;
+      std::cerr << "Exception on processing: " << std::endl
+                << exc.what() << std::endl
+                << "Aborting!" << std::endl
+                << "----------------------------------------------------"
+                << std::endl;
+      return 1;
+    }
+  catch (...)
+    {
+      std::cerr << std::endl
+                << std::endl
+                << "----------------------------------------------------"
+                << std::endl;
+      std::cerr << "Unknown exception!" << std::endl
+                << "Aborting!" << std::endl
+                << "----------------------------------------------------"
+                << std::endl;
+      return 1;
+    }
+}